@@ -13,6 +13,9 @@ MIDI_port * current_midi_port;
 
 RMR_Port_config * port_config;
 
+// Messages are read in batches of up to 64 events
+#define EVENT_BATCH_SIZE 64
+MIDI_event events[EVENT_BATCH_SIZE];
 MIDI_message * msg;
 error_message * err_msg;
 
@@ -48,13 +51,19 @@ int main() {
 
     // Run until SIGINT is received
     while (keep_process_running) {
-        while (g_async_queue_length(input_data->midi_async_queue)) {
-            // Read a message from a message queue
-            msg = g_async_queue_try_pop(input_data->midi_async_queue);
-            if (msg != NULL) {
-                // Print and deallocate a midi message instance
-                print_midi_msg_buf(msg->buf, msg->count);
-                free_midi_message(msg);
+        // Read all pending messages at once,
+        // wait up to 10 ms for the first one instead of spinning
+        size_t event_count = pop_midi_event_batch(input_data, events, EVENT_BATCH_SIZE, 10000);
+        for (size_t event_idx = 0; event_idx < event_count; event_idx++) {
+            if (events[event_idx].flags & MIDI_EVENT_PAYLOAD) {
+                // Print and deallocate a SysEx or a long message payload
+                msg = pop_midi_sysex(input_data);
+                if (msg != NULL) {
+                    print_midi_msg_buf(msg->buf, msg->count);
+                    free_midi_message(msg);
+                }
+            } else {
+                print_midi_msg_buf(events[event_idx].bytes, events[event_idx].count);
             }
         }
         while (g_async_queue_length(input_data->error_async_queue)) {
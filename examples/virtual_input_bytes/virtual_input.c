@@ -40,8 +40,17 @@ int main() {
     // so the program can exit
     signal(SIGINT, sigint_handler);
 
+    // Wait on a descriptor signalled by the input thread
+    // instead of checking queues in a busy loop
+    struct pollfd poll_fd = { .fd = get_midi_input_fd(input_data), .events = POLLIN };
+
     // Run until SIGINT is received
     while (keep_process_running) {
+        // Sleep until messages or errors arrive, wake up
+        // periodically to check keep_process_running
+        poll(&poll_fd, 1, 100);
+        // Clear a signal before reading, so new messages signal it again
+        clear_midi_input_wakeup(input_data);
         while (g_async_queue_length(input_data->midi_async_queue)) {
             // Read a message from a message queue
             msg = g_async_queue_try_pop(input_data->midi_async_queue);
@@ -53,7 +62,7 @@ int main() {
         while (g_async_queue_length(input_data->error_async_queue)) {
             // Read an error message from an error queue,
             // simply deallocate it for now
-            err_msg = g_async_queue_try_pop(input_data->midi_async_queue);
+            err_msg = g_async_queue_try_pop(input_data->error_async_queue);
             if (err_msg != NULL) free_error_message(err_msg);
         }
     }
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdbool.h>
+// Keeps process running until Ctrl-C is pressed.
+// Contains a SIGINT handler and keep_process_running variable.
+#include "util/exit_handling.h"
+#include "util/output_handling.h"
+// Main RMR header file
+#include "midi/midi_handling.h"
+
+Alsa_MIDI_data * data;
+MIDI_in_data * input_data;
+
+RMR_Port_config * port_config;
+
+error_message * err_msg;
+
+// A slow handler, like logging or a patch lookup
+void event_handler(MIDI_event event, const unsigned char * sysex, void * user_data) {
+    // The input thread keeps reading events meanwhile
+    g_usleep(5000);
+    printf("%d:%d | ", event.source.client, event.source.port);
+    if (sysex) print_midi_msg_buf(sysex, event.sysex_count);
+    else print_midi_msg_buf(event.bytes, event.count);
+}
+
+int main() {
+    // Create a port configuration with default values
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    // Callbacks run on 4 workers, messages of a sender port and channel
+    // always go to the same worker, so their order is kept
+    port_config->callback_workers = 4;
+    // Up to 512 messages wait for every worker, newer ones are dropped
+    port_config->callback_queue_size = 512;
+
+    // Allocate a MIDI_in_data instance, assign a
+    // MIDI message queue and an error queue
+    prepare_input_data(&input_data, port_config);
+
+    // Workers call this handler instead of the input thread
+    set_MIDI_in_event_callback(input_data, event_handler, NULL);
+
+    // Start a port with a provided configruation
+    start_port(&data, port_config);
+
+    // Assign amidi_data to input_data instance
+    assign_midi_data(input_data, data);
+
+    // Open a new port with a pre-set name, workers are started with the input thread
+    open_virtual_port(data, "rmr", input_data);
+
+    // Don't exit until Ctrl-C is pressed;
+    // Look up "output_handling.h"
+    keep_process_running = 1;
+
+    // Add a SIGINT handler to set keep_process_running to 0
+    // so the program can exit
+    signal(SIGINT, sigint_handler);
+
+    // Run until SIGINT is received
+    while (keep_process_running) {
+        while ((err_msg = g_async_queue_try_pop(input_data->error_async_queue)) != NULL) {
+            // Simply deallocate error messages for now
+            free_error_message(err_msg);
+        }
+        g_usleep(10000);
+    }
+
+    // Close a MIDI input port, shutdown the input thread
+    // and workers after they run pending callbacks
+    destroy_midi_input(data, input_data);
+
+    // Free input data and worker queues
+    destroy_input_data(input_data);
+
+    // Destroy a port configuration
+    destroy_port_config(port_config);
+
+    // Exit without an error
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <sys/epoll.h>
+// Keeps process running until Ctrl-C is pressed.
+// Contains a SIGINT handler and keep_process_running variable.
+#include "util/exit_handling.h"
+#include "util/output_handling.h"
+#include "util/midi_parsing.h"
+// Main RMR header file
+#include "midi/midi_handling.h"
+
+// Amount of events read from a ring buffer at once
+#define EVENT_BATCH_SIZE 64
+// Amount of epoll events handled per wakeup
+#define MAX_EPOLL_EVENTS 8
+
+Alsa_MIDI_data * data;
+MIDI_in_data * input_data;
+
+MIDI_event events[EVENT_BATCH_SIZE];
+MIDI_message * sysex;
+error_message * err_msg;
+
+RMR_Port_config * port_config;
+
+int main() {
+    struct epoll_event ev, ready[MAX_EPOLL_EVENTS];
+
+    // Create a port configuration with default values
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    // Pass events through a lock-free ring buffer
+    port_config->queue_type = MQ_EVENT_RING;
+
+    // Allocate a MIDI_in_data instance with a ring buffer,
+    // an error queue and a wakeup descriptor
+    prepare_input_data(&input_data, port_config);
+
+    // Start a port with a provided configruation
+    start_port(&data, port_config);
+
+    // Assign amidi_data to input_data instance
+    assign_midi_data(input_data, data);
+
+    // Open a new port with a pre-set name
+    open_virtual_port(data, "rmr", input_data);
+
+    // Add an input descriptor to an application's epoll set,
+    // other descriptors (sockets, timers) could be added next to it
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    ev.events = EPOLLIN;
+    ev.data.ptr = input_data;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, get_midi_input_fd(input_data), &ev);
+
+    // Don't exit until Ctrl-C is pressed;
+    // Look up "output_handling.h"
+    keep_process_running = 1;
+
+    // Add a SIGINT handler to set keep_process_running to 0
+    // so the program can exit
+    signal(SIGINT, sigint_handler);
+
+    // Run until SIGINT is received
+    while (keep_process_running) {
+        // Sleep until a descriptor is ready, wake up
+        // periodically to check keep_process_running
+        int ready_count = epoll_wait(epoll_fd, ready, MAX_EPOLL_EVENTS, 100);
+        for (int ready_idx = 0; ready_idx < ready_count; ready_idx++) {
+            MIDI_in_data * ready_input = ready[ready_idx].data.ptr;
+            // Clear a signal first, then read until queues are empty:
+            // a burst of messages signals a descriptor once
+            clear_midi_input_wakeup(ready_input);
+            size_t count;
+            while ((count = pop_midi_event_batch(ready_input, events, EVENT_BATCH_SIZE, 0)) > 0) {
+                for (size_t event_idx = 0; event_idx < count; event_idx++) {
+                    if (events[event_idx].flags & MIDI_EVENT_PAYLOAD) {
+                        sysex = pop_midi_sysex(ready_input);
+                        if (sysex != NULL) {
+                            print_midi_msg_buf(sysex->buf, sysex->count);
+                            free_midi_message(sysex);
+                        }
+                    } else {
+                        print_midi_msg_buf(events[event_idx].bytes, events[event_idx].count);
+                    }
+                }
+            }
+            // Errors signal the same descriptor,
+            // simply deallocate them for now
+            while ((err_msg = g_async_queue_try_pop(ready_input->error_async_queue)) != NULL) {
+                free_error_message(err_msg);
+            }
+        }
+    }
+
+    close(epoll_fd);
+
+    // Close a MIDI input port, shutdown the input thread,
+    // do cleanup
+    destroy_midi_input(data, input_data);
+
+    // Free the remaining input data
+    destroy_input_data(input_data);
+
+    // Destroy a port configuration
+    destroy_port_config(port_config);
+
+    // Exit without an error
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+// Keeps process running until Ctrl-C is pressed.
+// Contains a SIGINT handler and keep_process_running variable.
+#include "util/exit_handling.h"
+#include "util/output_handling.h"
+// Main RMR header file
+#include "midi/midi_handling.h"
+
+Alsa_MIDI_data * data;
+MIDI_in_data * input_data;
+
+RMR_Port_config * port_config;
+
+// Two independent readers of the same port
+MIDI_consumer * printer;
+MIDI_consumer * recorder;
+
+MIDI_event event;
+MIDI_shared_payload * sysex;
+error_message * err_msg;
+
+// A second thread only counts what it gets, like a recorder would store it
+void * record_input(void * arg) {
+    MIDI_event recorded;
+    MIDI_shared_payload * recorded_sysex;
+    unsigned long message_count = 0;
+    unsigned long sysex_bytes = 0;
+    (void) arg;
+    while (keep_process_running) {
+        clear_consumer_wakeup(recorder);
+        while (pop_consumer_event(recorder, &recorded, &recorded_sysex)) {
+            message_count++;
+            if (recorded_sysex) {
+                sysex_bytes += recorded_sysex->count;
+                // The payload is freed by whichever consumer releases it last
+                release_shared_payload(recorded_sysex);
+            }
+        }
+        g_usleep(10000);
+    }
+    printf("Recorded %lu messages, %lu SysEx bytes\n", message_count, sysex_bytes);
+    return NULL;
+}
+
+int main() {
+    pthread_t recorder_thread;
+    // Create a port configuration with default values
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    // Every consumer gets all messages in a ring of its own
+    port_config->fan_out = true;
+
+    // Allocate a MIDI_in_data instance, assign a
+    // MIDI message queue and an error queue
+    prepare_input_data(&input_data, port_config);
+
+    // A printer loses the oldest messages when it falls behind,
+    // a recorder drops new ones; neither slows down the other
+    add_midi_consumer(input_data, 256, OP_DROP_OLDEST, &printer);
+    add_midi_consumer(input_data, 4096, OP_DROP_NEWEST, &recorder);
+
+    // Start a port with a provided configruation
+    start_port(&data, port_config);
+
+    // Assign amidi_data to input_data instance
+    assign_midi_data(input_data, data);
+
+    // Open a new port with a pre-set name
+    open_virtual_port(data, "rmr", input_data);
+
+    // Don't exit until Ctrl-C is pressed;
+    // Look up "output_handling.h"
+    keep_process_running = 1;
+
+    // Add a SIGINT handler to set keep_process_running to 0
+    // so the program can exit
+    signal(SIGINT, sigint_handler);
+
+    pthread_create(&recorder_thread, NULL, record_input, NULL);
+
+    // Run until SIGINT is received
+    while (keep_process_running) {
+        clear_consumer_wakeup(printer);
+        while (pop_consumer_event(printer, &event, &sysex)) {
+            if (sysex) {
+                print_midi_msg_buf(sysex->bytes, sysex->count);
+                release_shared_payload(sysex);
+            } else {
+                print_midi_msg_buf(event.bytes, event.count);
+            }
+        }
+        while ((err_msg = g_async_queue_try_pop(input_data->error_async_queue)) != NULL) {
+            // Simply deallocate error messages for now
+            free_error_message(err_msg);
+        }
+        g_usleep(10000);
+    }
+
+    pthread_join(recorder_thread, NULL);
+    printf("Printer dropped %lu messages\n", get_consumer_drops(printer));
+
+    // Close a MIDI input port, shutdown the input thread,
+    // do cleanup
+    destroy_midi_input(data, input_data);
+
+    // Free input data, consumer rings and unread payloads
+    destroy_input_data(input_data);
+
+    // Destroy a port configuration
+    destroy_port_config(port_config);
+
+    // Exit without an error
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdbool.h>
+// Keeps process running until Ctrl-C is pressed.
+// Contains a SIGINT handler and keep_process_running variable.
+#include "util/exit_handling.h"
+#include "util/output_handling.h"
+// Main RMR header file
+#include "midi/midi_handling.h"
+
+Alsa_MIDI_data * data;
+MIDI_in_data * input_data;
+
+RMR_Port_config * port_config;
+
+// Messages are read in batches of up to 64 events
+#define EVENT_BATCH_SIZE 64
+MIDI_event events[EVENT_BATCH_SIZE];
+MIDI_message * msg;
+error_message * err_msg;
+
+unsigned long clock_count = 0;
+
+int main() {
+    // Create a port configuration with default values
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    // Realtime and SysEx messages get their own lanes,
+    // so a long SysEx dump doesn't delay clock messages
+    port_config->priority_lanes = true;
+
+    // Allocate a MIDI_in_data instance, assign a
+    // MIDI message queue and an error queue
+    prepare_input_data(&input_data, port_config);
+
+    // Start a port with a provided configruation
+    start_port(&data, port_config);
+
+    // Assign amidi_data to input_data instance
+    assign_midi_data(input_data, data);
+
+    // Open a new port with a pre-set name
+    open_virtual_port(data, "rmr", input_data);
+
+    // Don't exit until Ctrl-C is pressed;
+    // Look up "output_handling.h"
+    keep_process_running = 1;
+
+    // Add a SIGINT handler to set keep_process_running to 0
+    // so the program can exit
+    signal(SIGINT, sigint_handler);
+
+    // Run until SIGINT is received
+    while (keep_process_running) {
+        // Realtime events come first in every batch, SysEx events come last
+        size_t event_count = pop_midi_event_batch(input_data, events, EVENT_BATCH_SIZE, 10000);
+        for (size_t event_idx = 0; event_idx < event_count; event_idx++) {
+            if (events[event_idx].flags & MIDI_EVENT_PAYLOAD) {
+                // Print and deallocate a SysEx or a long message payload
+                msg = pop_midi_sysex(input_data);
+                if (msg != NULL) {
+                    print_midi_msg_buf(msg->buf, msg->count);
+                    free_midi_message(msg);
+                }
+            } else if (events[event_idx].bytes[0] == 0xF8) {
+                // Print every 24th clock, once per quarter note
+                if (clock_count++ % 24 == 0) printf("clock: %lu\n", clock_count);
+            } else {
+                print_midi_msg_buf(events[event_idx].bytes, events[event_idx].count);
+            }
+        }
+        while ((err_msg = g_async_queue_try_pop(input_data->error_async_queue)) != NULL) {
+            // Simply deallocate error messages for now
+            free_error_message(err_msg);
+        }
+    }
+
+    // Close a MIDI input port, shutdown the input thread,
+    // do cleanup
+    destroy_midi_input(data, input_data);
+
+    // Destroy a port configuration
+    destroy_port_config(port_config);
+
+    // Exit without an error
+    return 0;
+}
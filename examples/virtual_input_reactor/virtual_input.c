@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+// Keeps process running until Ctrl-C is pressed.
+// Contains a SIGINT handler and keep_process_running variable.
+#include "util/exit_handling.h"
+#include "util/output_handling.h"
+#include "util/midi_parsing.h"
+// Main RMR header file
+#include "midi/midi_handling.h"
+
+// An amount of virtual input ports served by a single thread
+#define PORT_COUNT 4
+
+Alsa_MIDI_data * data[PORT_COUNT];
+MIDI_in_data * input_data[PORT_COUNT];
+
+RMR_Port_config * port_config;
+
+MIDI_reactor * reactor;
+
+void message_handler(
+    double timestamp,
+    uint64_t time_ns,
+    const unsigned char * buf,
+    long count,
+    void * user_data
+) {
+    // Called from a reactor thread for every port
+    MIDI_in_data * port_input = (MIDI_in_data *) user_data;
+    snd_seq_addr_t source = get_midi_input_source(port_input);
+    printf("%3d:%-3d | ", source.client, source.port);
+    print_midi_msg_buf(buf, count);
+}
+
+int main() {
+    char port_name[32];
+
+    // Create a port configuration with default values
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    // Ports don't start their own threads, a reactor handles them
+    port_config->threadless = true;
+
+    // Create a reactor, it waits on all ports at once
+    init_midi_reactor(&reactor);
+
+    for (int port_idx = 0; port_idx < PORT_COUNT; port_idx++) {
+        // Allocate a MIDI_in_data instance, assign a
+        // MIDI message queue and an error queue
+        prepare_input_data(&input_data[port_idx], port_config);
+        // Start a port with a provided configruation
+        start_port(&data[port_idx], port_config);
+        // Assign amidi_data to input_data instance
+        assign_midi_data(input_data[port_idx], data[port_idx]);
+        // A callback receives its input data to look up a message source
+        set_MIDI_in_lending_callback(input_data[port_idx], message_handler, input_data[port_idx]);
+        // Open a new port with a numbered name
+        snprintf(port_name, sizeof(port_name), "rmr %d", port_idx);
+        open_virtual_port(data[port_idx], port_name, input_data[port_idx]);
+        // Let a reactor wait for port input
+        add_reactor_input(reactor, input_data[port_idx]);
+    }
+
+    // A single thread handles input of every port
+    start_midi_reactor(reactor);
+
+    // Don't exit until Ctrl-C is pressed;
+    // Look up "output_handling.h"
+    keep_process_running = 1;
+
+    // Add a SIGINT handler to set keep_process_running to 0
+    // so the program can exit
+    signal(SIGINT, sigint_handler);
+
+    // Run until SIGINT is received
+    while (keep_process_running) {
+        g_usleep(100000);
+    }
+
+    // Stop a reactor thread before closing ports
+    free_midi_reactor(reactor);
+
+    for (int port_idx = 0; port_idx < PORT_COUNT; port_idx++) {
+        // Close a MIDI input port, do cleanup
+        destroy_midi_input(data[port_idx], input_data[port_idx]);
+        // Free the remaining input data
+        destroy_input_data(input_data[port_idx]);
+    }
+
+    // Destroy a port configuration
+    destroy_port_config(port_config);
+
+    // Exit without an error
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+// Keeps process running until Ctrl-C is pressed.
+// Contains a SIGINT handler and keep_process_running variable.
+#include "util/exit_handling.h"
+#include "util/output_handling.h"
+#include "util/midi_parsing.h"
+// Main RMR header file
+#include "midi/midi_handling.h"
+
+Alsa_MIDI_data * data;
+MIDI_in_data * input_data;
+
+error_message * err_msg;
+
+RMR_Port_config * port_config;
+
+void message_handler(
+    double timestamp,
+    uint64_t time_ns,
+    const unsigned char * buf,
+    long count,
+    void * user_data
+) {
+    // Messages are counted by a port, nothing to do here
+}
+
+int main() {
+    MIDI_port_stats_snapshot stats;
+
+    // Create a port configuration with default values
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    // Measure time spent in message_handler
+    port_config->time_callbacks = true;
+
+    // Allocate a MIDI_in_data instance, assign a
+    // MIDI message queue and an error queue
+    prepare_input_data(&input_data, port_config);
+
+    // Start a port with a provided configruation
+    start_port(&data, port_config);
+
+    // Assign amidi_data to input_data instance
+    assign_midi_data(input_data, data);
+
+    // Open a new port with a pre-set name
+    open_virtual_port(data, "rmr", input_data);
+
+    set_MIDI_in_lending_callback(input_data, message_handler, NULL);
+
+    // Don't exit until Ctrl-C is pressed;
+    // Look up "output_handling.h"
+    keep_process_running = 1;
+
+    // Add a SIGINT handler to set keep_process_running to 0
+    // so the program can exit
+    signal(SIGINT, sigint_handler);
+
+    // Print counters once a second, input is not interrupted
+    while (keep_process_running) {
+        err_msg = g_async_queue_timeout_pop(input_data->error_async_queue, 1000000);
+        if (err_msg != NULL) free_error_message(err_msg);
+        get_midi_port_stats(data, input_data, &stats);
+        printf(
+            "channel: %lu msg, %lu B | common: %lu | realtime: %lu | sysex: %lu msg, %lu B | "
+            "overruns: %lu | callbacks: %lu, %lu ns\n",
+            stats.messages[MC_CHANNEL], stats.bytes[MC_CHANNEL],
+            stats.messages[MC_SYSTEM_COMMON],
+            stats.messages[MC_REALTIME],
+            stats.messages[MC_SYSEX], stats.bytes[MC_SYSEX],
+            stats.input_overruns,
+            stats.callback_calls, stats.callback_ns
+        );
+    }
+
+    // Close a MIDI input port, shutdown the input thread,
+    // do cleanup
+    destroy_midi_input(data, input_data);
+
+    // Destroy a port configuration
+    destroy_port_config(port_config);
+
+    // Exit without an error
+    return 0;
+}
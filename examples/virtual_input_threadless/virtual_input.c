@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+// Keeps process running until Ctrl-C is pressed.
+// Contains a SIGINT handler and keep_process_running variable.
+#include "util/exit_handling.h"
+#include "util/output_handling.h"
+#include "util/midi_parsing.h"
+// Main RMR header file
+#include "midi/midi_handling.h"
+
+// A maximal amount of sequencer descriptors to poll
+#define MAX_POLL_FDS 8
+
+Alsa_MIDI_data * data;
+MIDI_in_data * input_data;
+
+error_message * err_msg;
+
+RMR_Port_config * port_config;
+
+void message_handler(
+    double timestamp,
+    uint64_t time_ns,
+    const unsigned char * buf,
+    long count,
+    void * user_data
+) {
+    // Called from process_midi_input, in the main thread
+    print_midi_msg_buf(buf, count);
+}
+
+int main() {
+    struct pollfd poll_fds[MAX_POLL_FDS];
+
+    // Create a port configuration with default values
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    // Don't start an input thread, input is handled in the loop below
+    port_config->threadless = true;
+
+    // Allocate a MIDI_in_data instance, assign a
+    // MIDI message queue and an error queue
+    prepare_input_data(&input_data, port_config);
+
+    // Start a port with a provided configruation
+    start_port(&data, port_config);
+
+    // Assign amidi_data to input_data instance
+    assign_midi_data(input_data, data);
+
+    // Handle messages as soon as they are decoded
+    set_MIDI_in_lending_callback(input_data, message_handler, NULL);
+
+    // Open a new port with a pre-set name
+    open_virtual_port(data, "rmr", input_data);
+
+    // Sequencer descriptors could be added to any event loop
+    int poll_fd_count = get_midi_input_poll_descriptors(input_data, poll_fds, MAX_POLL_FDS);
+
+    // Don't exit until Ctrl-C is pressed;
+    // Look up "output_handling.h"
+    keep_process_running = 1;
+
+    // Add a SIGINT handler to set keep_process_running to 0
+    // so the program can exit
+    signal(SIGINT, sigint_handler);
+
+    // Run until SIGINT is received
+    while (keep_process_running) {
+        // Sleep until the sequencer has events, wake up
+        // periodically to check keep_process_running
+        if (poll(poll_fds, poll_fd_count, 100) > 0) {
+            // Decode events and call a callback inline
+            process_midi_input(input_data);
+        }
+        // Read an error message from an error queue,
+        // simply deallocate it for now
+        while ((err_msg = g_async_queue_try_pop(input_data->error_async_queue)) != NULL) {
+            free_error_message(err_msg);
+        }
+    }
+
+    // Close a MIDI input port, do cleanup
+    destroy_midi_input(data, input_data);
+
+    // Free the remaining input data
+    destroy_input_data(input_data);
+
+    // Destroy a port configuration
+    destroy_port_config(port_config);
+
+    // Exit without an error
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+// Keeps process running until Ctrl-C is pressed.
+// Contains a SIGINT handler and keep_process_running variable.
+#include "util/exit_handling.h"
+#include "util/output_handling.h"
+// Main RMR header file
+#include "midi/midi_handling.h"
+
+Alsa_MIDI_data * data;
+MIDI_in_data * input_data;
+
+error_message * err_msg;
+
+RMR_Port_config * port_config;
+
+unsigned long clock_count = 0;
+
+// Fields are decoded already, no status byte parsing is needed
+void note_handler(const MIDI_typed_event * event, void * user_data) {
+    printf(
+        "%s: channel %d, note %d, velocity %d\n",
+        event->type == MF_NOTE_ON && event->value > 0 ? "Note on" : "Note off",
+        event->channel + 1, event->number, event->value
+    );
+}
+
+void control_handler(const MIDI_typed_event * event, void * user_data) {
+    printf("Control change: channel %d, controller %d, value %d\n", event->channel + 1, event->number, event->value);
+}
+
+void pitch_bend_handler(const MIDI_typed_event * event, void * user_data) {
+    printf("Pitch bend: channel %d, value %d\n", event->channel + 1, event->value);
+}
+
+void clock_handler(const MIDI_typed_event * event, void * user_data) {
+    // Print every 24th clock, once per quarter note
+    if (clock_count++ % 24 == 0) printf("Clock: %lu\n", clock_count);
+}
+
+void sysex_handler(const MIDI_typed_event * event, void * user_data) {
+    printf("SysEx: %ld bytes\n", event->sysex_count);
+}
+
+int main() {
+    // Create a port configuration with default values
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+
+    // Allocate a MIDI_in_data instance, assign a
+    // MIDI message queue and an error queue
+    prepare_input_data(&input_data, port_config);
+
+    // Start a port with a provided configruation
+    start_port(&data, port_config);
+
+    // Assign amidi_data to input_data instance
+    assign_midi_data(input_data, data);
+
+    // Register handlers before a port is opened,
+    // messages of other types are queued as usual
+    set_MIDI_in_typed_callback(input_data, MF_NOTE_ON, note_handler, NULL);
+    set_MIDI_in_typed_callback(input_data, MF_NOTE_OFF, note_handler, NULL);
+    set_MIDI_in_typed_callback(input_data, MF_CONTROL_CHANGE, control_handler, NULL);
+    set_MIDI_in_typed_callback(input_data, MF_PITCH_BEND, pitch_bend_handler, NULL);
+    set_MIDI_in_typed_callback(input_data, MF_CLOCK, clock_handler, NULL);
+    set_MIDI_in_typed_callback(input_data, MF_SYSEX, sysex_handler, NULL);
+
+    // Open a new port with a pre-set name
+    open_virtual_port(data, "rmr", input_data);
+
+    // Don't exit until Ctrl-C is pressed;
+    // Look up "output_handling.h"
+    keep_process_running = 1;
+
+    // Add a SIGINT handler to set keep_process_running to 0
+    // so the program can exit
+    signal(SIGINT, sigint_handler);
+
+    // Handlers are called by the input thread, only errors are read here
+    while (keep_process_running) {
+        err_msg = g_async_queue_timeout_pop(input_data->error_async_queue, 100000);
+        if (err_msg != NULL) free_error_message(err_msg);
+    }
+
+    // Close a MIDI input port, shutdown the input thread,
+    // do cleanup
+    destroy_midi_input(data, input_data);
+
+    // Destroy a port configuration
+    destroy_port_config(port_config);
+
+    // Exit without an error
+    return 0;
+}
@@ -0,0 +1,334 @@
+/**
+ * Worker threads running input callbacks outside of the input thread
+ */
+
+/** A default amount of pending callbacks of a worker */
+#define CALLBACK_QUEUE_SIZE 256
+/** An amount of preallocated SysEx buffers of a worker */
+#define CALLBACK_SYSEX_BUFFERS 16
+/** Size of a preallocated SysEx buffer, longer messages are copied to heap memory */
+#define CALLBACK_SYSEX_BUFFER_SIZE 512
+
+/**
+ * A callback call handed off by the input thread to a worker.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_callback_job {
+    /** A message, bytes of long and SysEx messages are passed in sysex */
+    MIDI_event event;
+    /** Time in seconds elapsed since the previous message */
+    double timestamp;
+    /** A copy of message bytes when a :c:data:`MIDI_EVENT_PAYLOAD` flag is set,
+        released by a worker after a call; **NULL** otherwise */
+    unsigned char * sysex;
+    /** Set when sysex is a preallocated buffer of a worker, a heap copy otherwise */
+    bool pooled_sysex;
+} MIDI_callback_job;
+
+/**
+ * A function running a handed off job in a worker thread.
+ */
+typedef void ( * MIDI_callback_job_handler ) (const MIDI_callback_job * job, void * context);
+
+/**
+ * A worker thread with its own bounded queue of jobs.
+ * The input thread is the only producer, the worker is the only consumer.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_callback_worker {
+    /** A lock-free ring of :c:type:`MIDI_callback_job` values */
+    MIDI_ring_buffer * jobs;
+    /** A worker thread */
+    pthread_t thread;
+    /** An eventfd signalled when jobs are published or a pool is stopped */
+    int wakeup_fd;
+    /** Set when wakeup_fd was signalled and not cleared yet, so a batch signals it once */
+    atomic_bool wakeup_pending;
+    /** Preallocated SysEx buffers, :c:data:`CALLBACK_SYSEX_BUFFERS` of
+        :c:data:`CALLBACK_SYSEX_BUFFER_SIZE` bytes */
+    unsigned char * sysex_buffers;
+    /** A lock-free ring of free SysEx buffer pointers:
+        a worker returns buffers, the input thread takes them */
+    MIDI_ring_buffer * free_sysex;
+    /** A pool of a worker */
+    struct MIDI_callback_pool * pool;
+} MIDI_callback_worker;
+
+/**
+ * Workers running callbacks of an input port, used with :c:member:`RMR_Port_config.callback_workers`.
+ * Messages of a single sender port and channel always go to the same worker,
+ * so they are handled in arrival order; messages of different senders or channels
+ * may be handled in parallel.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_callback_pool {
+    /** Workers */
+    MIDI_callback_worker * workers;
+    /** An amount of workers */
+    unsigned int worker_count;
+    /** A function running jobs */
+    MIDI_callback_job_handler handler;
+    /** Additional data passed to a handler */
+    void * context;
+    /** Set while workers should wait for new jobs */
+    atomic_bool running;
+    /** Set while worker threads exist */
+    bool started;
+    /** Signalled by workers when the input thread waits for room in a queue */
+    MIDI_room_signal room;
+} MIDI_callback_pool;
+
+/**
+ * Stops worker threads and waits for them to run pending jobs.
+ * Called after the input thread is stopped, so no jobs are added meanwhile.
+ *
+ * :param pool: a :c:type:`MIDI_callback_pool` instance
+ *
+ * :since: v0.2
+ */
+void stop_callback_pool(MIDI_callback_pool * pool) {
+    if (!pool->started) return;
+    atomic_store(&pool->running, false);
+    for (unsigned int worker_idx = 0; worker_idx < pool->worker_count; worker_idx++) {
+        // A stop signal is sent even when a job signal is pending
+        uint64_t one = 1;
+        int res = write(pool->workers[worker_idx].wakeup_fd, &one, sizeof(one));
+        (void) res;
+    }
+    for (unsigned int worker_idx = 0; worker_idx < pool->worker_count; worker_idx++)
+        pthread_join(pool->workers[worker_idx].thread, NULL);
+    pool->started = false;
+}
+
+/**
+ * Deallocates a :c:type:`MIDI_callback_pool` instance, its queues and jobs nobody ran.
+ * Running workers are stopped first.
+ *
+ * :param pool: a :c:type:`MIDI_callback_pool` instance or **NULL**
+ *
+ * :since: v0.2
+ */
+void free_callback_pool(MIDI_callback_pool * pool) {
+    MIDI_callback_job job;
+    if (pool == NULL) return;
+    // An input thread may have ended on an error without stopping workers
+    stop_callback_pool(pool);
+    if (pool->workers) {
+        for (unsigned int worker_idx = 0; worker_idx < pool->worker_count; worker_idx++) {
+            MIDI_callback_worker * worker = &pool->workers[worker_idx];
+            if (worker->jobs) {
+                // Pooled buffers are freed with their storage
+                while (ring_buffer_pop(worker->jobs, &job)) if (!job.pooled_sysex) free(job.sysex);
+                free_ring_buffer(worker->jobs);
+            }
+            free_ring_buffer(worker->free_sysex);
+            free(worker->sysex_buffers);
+            if (worker->wakeup_fd >= 0) close(worker->wakeup_fd);
+        }
+        free(pool->workers);
+    }
+    free_room_signal(&pool->room);
+    free(pool);
+}
+
+/**
+ * Allocates a :c:type:`MIDI_callback_pool` instance and queues of its workers,
+ * threads are started by :c:func:`start_callback_pool`.
+ *
+ * :param pool: a double pointer used to allocate memory for a :c:type:`MIDI_callback_pool` instance
+ * :param worker_count: an amount of workers
+ * :param queue_size: an amount of pending jobs of a worker, rounded up to a power of two
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int init_callback_pool(MIDI_callback_pool ** pool, unsigned int worker_count, size_t queue_size) {
+    int result = 0;
+    * pool = NULL;
+    do {
+        if (worker_count == 0) {
+            result = -1;
+            break;
+        }
+        * pool = calloc(1, sizeof(MIDI_callback_pool));
+        if (* pool == NULL) {
+            result = -1;
+            break;
+        }
+        atomic_init(&(* pool)->running, false);
+        init_room_signal(&(* pool)->room);
+        (* pool)->worker_count = worker_count;
+        (* pool)->workers = calloc(worker_count, sizeof(MIDI_callback_worker));
+        if ((* pool)->workers == NULL) {
+            free_callback_pool(* pool);
+            * pool = NULL;
+            result = -1;
+            break;
+        }
+        // Descriptors are marked as absent first, so a partial pool is freed safely
+        for (unsigned int worker_idx = 0; worker_idx < worker_count; worker_idx++)
+            (* pool)->workers[worker_idx].wakeup_fd = -1;
+        for (unsigned int worker_idx = 0; worker_idx < worker_count; worker_idx++) {
+            MIDI_callback_worker * worker = &(* pool)->workers[worker_idx];
+            worker->pool = * pool;
+            atomic_init(&worker->wakeup_pending, false);
+            worker->wakeup_fd = eventfd(0, EFD_CLOEXEC);
+            worker->sysex_buffers = malloc(CALLBACK_SYSEX_BUFFERS * CALLBACK_SYSEX_BUFFER_SIZE);
+            if (
+                worker->wakeup_fd < 0 || worker->sysex_buffers == NULL ||
+                init_ring_buffer(&worker->jobs, queue_size, sizeof(MIDI_callback_job)) != 0 ||
+                init_ring_buffer(&worker->free_sysex, CALLBACK_SYSEX_BUFFERS, sizeof(unsigned char *)) != 0
+            ) {
+                result = -1;
+                break;
+            }
+            for (unsigned int buffer_idx = 0; buffer_idx < CALLBACK_SYSEX_BUFFERS; buffer_idx++) {
+                unsigned char * buffer = worker->sysex_buffers + buffer_idx * CALLBACK_SYSEX_BUFFER_SIZE;
+                ring_buffer_push(worker->free_sysex, &buffer);
+            }
+        }
+        if (result != 0) {
+            free_callback_pool(* pool);
+            * pool = NULL;
+        }
+    } while (0);
+    return result;
+}
+
+/**
+ * Takes a buffer for SysEx bytes of a job: a preallocated one when it is free and long enough,
+ * heap memory otherwise. Called from the input thread only.
+ *
+ * :param worker: a :c:type:`MIDI_callback_worker` a job goes to
+ * :param job: a :c:type:`MIDI_callback_job` instance, its sysex and pooled_sysex are set
+ * :param count: length of a message
+ *
+ * :returns: **0** on success, **-1** when memory can't be allocated
+ *
+ * :since: v0.2
+ */
+int take_job_sysex(MIDI_callback_worker * worker, MIDI_callback_job * job, long count) {
+    job->pooled_sysex = count <= CALLBACK_SYSEX_BUFFER_SIZE && ring_buffer_pop(worker->free_sysex, &job->sysex);
+    if (!job->pooled_sysex) job->sysex = malloc(count);
+    return job->sysex == NULL ? -1 : 0;
+}
+
+/**
+ * Returns a SysEx buffer of a job after a call. Called from a worker thread only.
+ *
+ * :param worker: a :c:type:`MIDI_callback_worker` that ran a job
+ * :param job: a :c:type:`MIDI_callback_job` instance
+ *
+ * :since: v0.2
+ */
+void release_job_sysex(MIDI_callback_worker * worker, MIDI_callback_job * job) {
+    // A ring holds every buffer, so a push never fails
+    if (job->pooled_sysex) ring_buffer_push(worker->free_sysex, &job->sysex);
+    else free(job->sysex);
+}
+
+/**
+ * Runs jobs of a worker until its pool is stopped, jobs left at that moment are run too.
+ *
+ * :param ptr: a void-pointer to :c:type:`MIDI_callback_worker`
+ *
+ * :since: v0.2
+ */
+void * run_callback_worker(void * ptr) {
+    MIDI_callback_worker * worker = ptr;
+    MIDI_callback_pool * pool = worker->pool;
+    MIDI_callback_job job;
+    uint64_t value;
+    while (1) {
+        // A signal is cleared before a queue is checked, so a job published in between wakes a worker again
+        atomic_store(&worker->wakeup_pending, false);
+        while (ring_buffer_pop(worker->jobs, &job)) {
+            pool->handler(&job, pool->context);
+            release_job_sysex(worker, &job);
+            signal_room(&pool->room);
+        }
+        if (!atomic_load(&pool->running)) break;
+        int res = read(worker->wakeup_fd, &value, sizeof(value));
+        (void) res;
+    }
+    return NULL;
+}
+
+/**
+ * Starts worker threads. Does nothing when they are running already.
+ *
+ * :param pool: a :c:type:`MIDI_callback_pool` instance
+ * :param handler: a function running jobs
+ * :param context: additional data passed to a handler
+ *
+ * :returns: **0** on success, **-1** when a thread can't be started
+ *
+ * :since: v0.2
+ */
+int start_callback_pool(MIDI_callback_pool * pool, MIDI_callback_job_handler handler, void * context) {
+    int result = 0;
+    if (pool->started) return 0;
+    pool->handler = handler;
+    pool->context = context;
+    atomic_store(&pool->running, true);
+    for (unsigned int worker_idx = 0; worker_idx < pool->worker_count; worker_idx++) {
+        if (pthread_create(&pool->workers[worker_idx].thread, NULL, run_callback_worker, &pool->workers[worker_idx]) != 0) {
+            // Started workers are stopped, so a pool is either fully running or not at all
+            atomic_store(&pool->running, false);
+            for (unsigned int started_idx = 0; started_idx < worker_idx; started_idx++) {
+                uint64_t one = 1;
+                int res = write(pool->workers[started_idx].wakeup_fd, &one, sizeof(one));
+                (void) res;
+                pthread_join(pool->workers[started_idx].thread, NULL);
+            }
+            result = -1;
+            break;
+        }
+    }
+    if (result == 0) pool->started = true;
+    return result;
+}
+
+/**
+ * Selects a worker of a message, the same sender port and channel always get the same worker.
+ *
+ * :param pool: a :c:type:`MIDI_callback_pool` instance
+ * :param source: a sender of a message
+ * :param status: a first byte of a message
+ *
+ * :returns: a :c:type:`MIDI_callback_worker` instance
+ *
+ * :since: v0.2
+ */
+MIDI_callback_worker * get_callback_worker(MIDI_callback_pool * pool, snd_seq_addr_t source, unsigned char status) {
+    // System messages share a key of their own
+    unsigned int channel = status >= 0x80 && status < 0xF0 ? status & 0x0F : 16;
+    unsigned int key = ((unsigned int) source.client << 8 | source.port) * 17 + channel;
+    // Multiplicative hashing spreads nearby keys over workers
+    return &pool->workers[(key * 2654435761u >> 16) % pool->worker_count];
+}
+
+/**
+ * Makes pushed jobs visible and wakes workers that got them. Called from the input thread only.
+ *
+ * :param pool: a :c:type:`MIDI_callback_pool` instance
+ *
+ * :since: v0.2
+ */
+void publish_callback_jobs(MIDI_callback_pool * pool) {
+    for (unsigned int worker_idx = 0; worker_idx < pool->worker_count; worker_idx++) {
+        MIDI_callback_worker * worker = &pool->workers[worker_idx];
+        // Only the producer writes a head, so a relaxed load is enough
+        if (worker->jobs->head_pending == atomic_load_explicit(&worker->jobs->head, memory_order_relaxed))
+            continue;
+        ring_buffer_publish(worker->jobs);
+        if (atomic_exchange(&worker->wakeup_pending, true)) continue;
+        uint64_t one = 1;
+        int res = write(worker->wakeup_fd, &one, sizeof(one));
+        (void) res;
+    }
+}
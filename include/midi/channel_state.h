@@ -0,0 +1,219 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Current state of 16 MIDI channels, updated by the input thread and read without locks
+ */
+
+/** An amount of MIDI channels */
+#define MIDI_CHANNEL_COUNT 16
+
+/**
+ * A state of a single MIDI channel. Values are zero until messages set them,
+ * a pitch bend is centered at **0**.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_channel_state {
+    /** Values of all controllers */
+    unsigned char controllers[128];
+    /** Held notes, bit N of word N / 64 is set while note N is held */
+    uint64_t notes[2];
+    /** A pitch bend from -8192 to 8191 */
+    int pitch_bend;
+    /** A channel pressure */
+    unsigned char channel_pressure;
+    /** A program */
+    unsigned char program;
+} MIDI_channel_state;
+
+/**
+ * A channel state guarded by a sequence lock.
+ * A writer makes a sequence odd while it changes a state and even again after it,
+ * a reader copies a state and retries when a sequence was odd or has changed.
+ * A writer never waits, a reader never blocks a writer.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_channel_slot {
+    /** A sequence number, odd while a state is being changed */
+    atomic_uint sequence;
+    /** A channel state */
+    MIDI_channel_state state;
+} MIDI_channel_slot;
+
+/**
+ * States of all channels of an input port, used with :c:member:`RMR_Port_config.track_channel_state`.
+ * Written by the input thread only, read by any thread with :c:func:`read_channel_state`.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_state_tracker {
+    /** Channel states indexed by a channel from 0 to 15 */
+    MIDI_channel_slot channels[MIDI_CHANNEL_COUNT];
+} MIDI_state_tracker;
+
+/**
+ * Allocates a :c:type:`MIDI_state_tracker` instance with zero values.
+ *
+ * :param tracker: a double pointer used to allocate memory for a :c:type:`MIDI_state_tracker` instance
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int init_state_tracker(MIDI_state_tracker ** tracker) {
+    int result = 0;
+    // All-zero bytes are a valid initial state of atomic integers
+    * tracker = calloc(1, sizeof(MIDI_state_tracker));
+    if (* tracker == NULL) result = -1;
+    return result;
+}
+
+/**
+ * Deallocates a :c:type:`MIDI_state_tracker` instance.
+ *
+ * :param tracker: a :c:type:`MIDI_state_tracker` instance
+ *
+ * :since: v0.2
+ */
+void free_state_tracker(MIDI_state_tracker * tracker) {
+    free(tracker);
+}
+
+/**
+ * Starts a change of a channel state. Called by a single writer.
+ *
+ * :param slot: a :c:type:`MIDI_channel_slot` instance
+ *
+ * :since: v0.2
+ */
+void begin_channel_update(MIDI_channel_slot * slot) {
+    unsigned int sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+    // A state isn't changed before readers can see an odd sequence
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * Ends a change of a channel state, so readers can copy it. Called by a single writer.
+ *
+ * :param slot: a :c:type:`MIDI_channel_slot` instance
+ *
+ * :since: v0.2
+ */
+void end_channel_update(MIDI_channel_slot * slot) {
+    unsigned int sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_release);
+}
+
+/**
+ * Sets controllers and values reset by a "Reset All Controllers" message,
+ * following the MIDI recommended practice RP-015.
+ *
+ * :param state: a :c:type:`MIDI_channel_state` instance
+ *
+ * :since: v0.2
+ */
+void reset_channel_controllers(MIDI_channel_state * state) {
+    state->controllers[1] = 0;
+    state->controllers[11] = 127;
+    for (int controller = 64; controller <= 67; controller++) state->controllers[controller] = 0;
+    for (int controller = 98; controller <= 101; controller++) state->controllers[controller] = 127;
+    state->pitch_bend = 0;
+    state->channel_pressure = 0;
+}
+
+/**
+ * Applies an Alsa event to a channel state. Events that don't change
+ * a channel state are ignored. Called from the input thread only.
+ *
+ * :param tracker: a :c:type:`MIDI_state_tracker` instance
+ * :param ev: an Alsa sequencer event
+ *
+ * :since: v0.2
+ */
+void update_state_tracker(MIDI_state_tracker * tracker, const snd_seq_event_t * ev) {
+    // Note and control events keep a channel in the same place
+    MIDI_channel_slot * slot = &tracker->channels[ev->data.control.channel & 0x0F];
+    MIDI_channel_state * state = &slot->state;
+    unsigned int note = ev->data.note.note & 0x7F;
+    unsigned int param = ev->data.control.param & 0x7F;
+    switch (ev->type) {
+    case SND_SEQ_EVENT_NOTEON:
+        begin_channel_update(slot);
+        // A zero velocity is a note off
+        if (ev->data.note.velocity) state->notes[note >> 6] |= (uint64_t) 1 << (note & 63);
+        else state->notes[note >> 6] &= ~((uint64_t) 1 << (note & 63));
+        end_channel_update(slot);
+        break;
+    case SND_SEQ_EVENT_NOTEOFF:
+        begin_channel_update(slot);
+        state->notes[note >> 6] &= ~((uint64_t) 1 << (note & 63));
+        end_channel_update(slot);
+        break;
+    case SND_SEQ_EVENT_CONTROLLER:
+        begin_channel_update(slot);
+        state->controllers[param] = ev->data.control.value & 0x7F;
+        // All sound off and all notes off release held notes
+        if (param == 120 || param == 123) state->notes[0] = state->notes[1] = 0;
+        if (param == 121) reset_channel_controllers(state);
+        end_channel_update(slot);
+        break;
+    case SND_SEQ_EVENT_CONTROL14:
+        begin_channel_update(slot);
+        // Controllers 0 - 31 are paired with LSB controllers 32 - 63
+        if (param < 32) {
+            state->controllers[param] = (ev->data.control.value >> 7) & 0x7F;
+            state->controllers[param + 32] = ev->data.control.value & 0x7F;
+        } else {
+            state->controllers[param] = ev->data.control.value & 0x7F;
+        }
+        end_channel_update(slot);
+        break;
+    case SND_SEQ_EVENT_PGMCHANGE:
+        begin_channel_update(slot);
+        state->program = ev->data.control.value & 0x7F;
+        end_channel_update(slot);
+        break;
+    case SND_SEQ_EVENT_CHANPRESS:
+        begin_channel_update(slot);
+        state->channel_pressure = ev->data.control.value & 0x7F;
+        end_channel_update(slot);
+        break;
+    case SND_SEQ_EVENT_PITCHBEND:
+        begin_channel_update(slot);
+        state->pitch_bend = ev->data.control.value;
+        end_channel_update(slot);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Copies a consistent state of a channel without locks, safe to call from an audio thread.
+ * Retries while the input thread changes a channel, a change takes a few stores,
+ * so a reader rarely retries. Channels are copied one by one,
+ * states of different channels may be taken at different moments.
+ *
+ * :param tracker: a :c:type:`MIDI_state_tracker` instance
+ * :param channel: a channel from 0 to 15
+ * :param state: a :c:type:`MIDI_channel_state` instance to fill
+ *
+ * :since: v0.2
+ */
+void read_channel_state(MIDI_state_tracker * tracker, unsigned char channel, MIDI_channel_state * state) {
+    MIDI_channel_slot * slot = &tracker->channels[channel & 0x0F];
+    unsigned int sequence;
+    while (1) {
+        sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence & 1) continue;
+        memcpy(state, &slot->state, sizeof(MIDI_channel_state));
+        // A copy is finished before a sequence is checked again
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) == sequence) break;
+    }
+}
@@ -0,0 +1,259 @@
+/**
+ * Latest-value-wins storage of continuous controller messages
+ */
+
+/** Control change slots: 16 channels * 128 controllers */
+#define COALESCE_CONTROL_SLOTS 0
+/** Polyphonic key pressure slots: 16 channels * 128 notes */
+#define COALESCE_KEY_PRESSURE_SLOTS 2048
+/** Pitch bend slots: 16 channels */
+#define COALESCE_PITCH_BEND_SLOTS 4096
+/** Channel pressure slots: 16 channels */
+#define COALESCE_CHANNEL_PRESSURE_SLOTS 4112
+/** An amount of continuous parameters of a port */
+#define COALESCE_SLOT_COUNT 4128
+
+/**
+ * Finds a continuous parameter a message sets: a controller, a key pressure,
+ * a pitch bend or a channel pressure of a channel. Only its last value matters,
+ * so older values of the same parameter can be replaced by newer ones.
+ * Only a single complete message has a slot: several messages decoded from one Alsa event,
+ * like 14-bit controllers and parameter numbers, don't fit into a slot value.
+ *
+ * :param buf: message bytes
+ * :param count: length of buf
+ *
+ * :returns: a slot index below :c:data:`COALESCE_SLOT_COUNT`, **-1** for other messages
+ *
+ * :since: v0.2
+ */
+int get_coalesce_slot(const unsigned char * buf, long count) {
+    if (count < 2) return -1;
+    unsigned char channel = buf[0] & 0x0F;
+    switch (buf[0] & 0xF0) {
+    case 0xB0:
+        // Channel mode messages act once, they are not values
+        if (count != 3 || buf[1] >= 120) return -1;
+        return COALESCE_CONTROL_SLOTS + channel * 128 + buf[1];
+    case 0xA0:
+        if (count != 3) return -1;
+        return COALESCE_KEY_PRESSURE_SLOTS + channel * 128 + (buf[1] & 0x7F);
+    case 0xE0:
+        if (count != 3) return -1;
+        return COALESCE_PITCH_BEND_SLOTS + channel;
+    case 0xD0:
+        if (count != 2) return -1;
+        return COALESCE_CHANNEL_PRESSURE_SLOTS + channel;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * Continuous controller events that didn't fit into a full input queue,
+ * used by :c:member:`overflow_policy_t.OP_COALESCE`.
+ * A newer event of a parameter replaces a parked one, events are offered
+ * to a queue again in the order their parameters were parked.
+ * Used by the input thread only.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_parked_events {
+    /** Parked events indexed by :c:func:`get_coalesce_slot` */
+    MIDI_event events[COALESCE_SLOT_COUNT];
+    /** Marks slots holding an event */
+    bool used[COALESCE_SLOT_COUNT];
+    /** Used slots in the order they were parked */
+    uint16_t order[COALESCE_SLOT_COUNT];
+    /** An amount of used slots */
+    unsigned int count;
+} MIDI_parked_events;
+
+/**
+ * Allocates an empty :c:type:`MIDI_parked_events` instance.
+ *
+ * :param parked: a double pointer used to allocate memory for a :c:type:`MIDI_parked_events` instance
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int init_parked_events(MIDI_parked_events ** parked) {
+    int result = 0;
+    * parked = calloc(1, sizeof(MIDI_parked_events));
+    if (* parked == NULL) result = -1;
+    return result;
+}
+
+/**
+ * Deallocates a :c:type:`MIDI_parked_events` instance.
+ *
+ * :param parked: a :c:type:`MIDI_parked_events` instance
+ *
+ * :since: v0.2
+ */
+void free_parked_events(MIDI_parked_events * parked) {
+    free(parked);
+}
+
+/**
+ * Parks an event, replacing an older event of the same parameter.
+ *
+ * :param parked: a :c:type:`MIDI_parked_events` instance
+ * :param slot: a slot from :c:func:`get_coalesce_slot`
+ * :param event: an event to park
+ *
+ * :returns: **true** when an older event was replaced
+ *
+ * :since: v0.2
+ */
+bool park_event(MIDI_parked_events * parked, int slot, const MIDI_event * event) {
+    bool replaced = parked->used[slot];
+    parked->events[slot] = * event;
+    if (!replaced) {
+        parked->used[slot] = true;
+        parked->order[parked->count++] = (uint16_t) slot;
+    }
+    return replaced;
+}
+
+/** Marks a slot value a consumer hasn't read yet */
+#define COALESCE_PENDING ((uint64_t) 1 << 63)
+
+/**
+ * The latest values of continuous parameters shared by the input thread and a consumer,
+ * used with :c:member:`RMR_Port_config.coalesce_controllers`.
+ *
+ * A queue holds at most one message per parameter: the first value makes a slot pending
+ * and is queued, later values only replace a slot value. A consumer reading a queued
+ * message takes the latest value from a slot and clears it, so the next value is queued again.
+ * Both sides only exchange a single word, nothing is locked.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_coalesce_table {
+    /** Latest values: a :c:data:`COALESCE_PENDING` flag, a source client and port,
+        the second and the third message bytes packed into one word */
+    atomic_uint_least64_t values[COALESCE_SLOT_COUNT];
+    /** Times of latest values, nanoseconds or ticks */
+    atomic_uint_least64_t times[COALESCE_SLOT_COUNT];
+} MIDI_coalesce_table;
+
+/**
+ * Allocates an empty :c:type:`MIDI_coalesce_table` instance.
+ *
+ * :param table: a double pointer used to allocate memory for a :c:type:`MIDI_coalesce_table` instance
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int init_coalesce_table(MIDI_coalesce_table ** table) {
+    int result = 0;
+    // All-zero bytes are a valid initial state of atomic integers
+    * table = calloc(1, sizeof(MIDI_coalesce_table));
+    if (* table == NULL) result = -1;
+    return result;
+}
+
+/**
+ * Deallocates a :c:type:`MIDI_coalesce_table` instance.
+ *
+ * :param table: a :c:type:`MIDI_coalesce_table` instance
+ *
+ * :since: v0.2
+ */
+void free_coalesce_table(MIDI_coalesce_table * table) {
+    free(table);
+}
+
+/**
+ * Stores the latest value of a parameter. Called from the input thread only.
+ *
+ * :param table: a :c:type:`MIDI_coalesce_table` instance
+ * :param slot: a slot from :c:func:`get_coalesce_slot`
+ * :param buf: message bytes
+ * :param count: length of buf
+ * :param time: a message time, nanoseconds or ticks
+ * :param source: a sender of a message
+ *
+ * :returns: **true** when a queued message of a parameter will carry a value,
+ *           **false** when a message has to be queued
+ *
+ * :since: v0.2
+ */
+bool store_coalesced_value(
+    MIDI_coalesce_table * table,
+    int slot,
+    const unsigned char * buf,
+    long count,
+    uint64_t time,
+    snd_seq_addr_t source
+  ) {
+    uint64_t value = COALESCE_PENDING
+        | (uint64_t) source.client << 40 | (uint64_t) source.port << 32
+        | (uint64_t) (count > 2 ? buf[2] : 0) << 8 | buf[1];
+    atomic_store_explicit(&table->times[slot], time, memory_order_relaxed);
+    // Publishes a time too, a consumer takes a value with acquire ordering
+    uint64_t previous = atomic_exchange_explicit(&table->values[slot], value, memory_order_acq_rel);
+    return (previous & COALESCE_PENDING) != 0;
+}
+
+/**
+ * Takes the latest value of a parameter and clears its slot. Called from a consumer.
+ *
+ * :param table: a :c:type:`MIDI_coalesce_table` instance
+ * :param slot: a slot from :c:func:`get_coalesce_slot`
+ * :param buf: bytes of a queued message, replaced by the latest ones
+ * :param count: length of buf
+ * :param time: a message time to replace by the latest one
+ * :param source: a message sender to replace by the latest one
+ *
+ * :returns: **true** when a slot had a value
+ *
+ * :since: v0.2
+ */
+bool take_coalesced_value(
+    MIDI_coalesce_table * table,
+    int slot,
+    unsigned char * buf,
+    long count,
+    uint64_t * time,
+    snd_seq_addr_t * source
+  ) {
+    uint64_t value = atomic_exchange_explicit(&table->values[slot], 0, memory_order_acq_rel);
+    if (!(value & COALESCE_PENDING)) return false;
+    buf[1] = value & 0x7F;
+    if (count > 2) buf[2] = (value >> 8) & 0x7F;
+    source->client = (value >> 40) & 0xFF;
+    source->port = (value >> 32) & 0xFF;
+    * time = atomic_load_explicit(&table->times[slot], memory_order_relaxed);
+    return true;
+}
+
+/**
+ * Clears a slot whose queued message was dropped, so the next value is queued again.
+ * Called from the input thread only.
+ *
+ * :param table: a :c:type:`MIDI_coalesce_table` instance
+ * :param slot: a slot from :c:func:`get_coalesce_slot`
+ *
+ * :since: v0.2
+ */
+void clear_coalesced_value(MIDI_coalesce_table * table, int slot) {
+    atomic_store_explicit(&table->values[slot], 0, memory_order_release);
+}
+
+/**
+ * Checks if a slot has a value waiting for its queued message. Called from the input thread only.
+ *
+ * :param table: a :c:type:`MIDI_coalesce_table` instance
+ * :param slot: a slot from :c:func:`get_coalesce_slot`
+ *
+ * :returns: **true** when a queued message of a parameter carries a value
+ *
+ * :since: v0.2
+ */
+bool is_coalesced_value_pending(MIDI_coalesce_table * table, int slot) {
+    return (atomic_load_explicit(&table->values[slot], memory_order_acquire) & COALESCE_PENDING) != 0;
+}
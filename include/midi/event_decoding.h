@@ -0,0 +1,108 @@
+/**
+ * Fast-path conversion of Alsa sequencer events to MIDI bytes
+ */
+
+/** An Alsa event kind that is not handled by the fast path */
+#define FAST_EVENT_NONE 0
+/** A single status byte, realtime and some system common messages */
+#define FAST_EVENT_STATUS 1
+/** A status byte and a note number with a velocity */
+#define FAST_EVENT_NOTE 2
+/** A status byte and a controller number with a value */
+#define FAST_EVENT_CONTROL 3
+/** A status byte and a single 7-bit value */
+#define FAST_EVENT_VALUE 4
+/** A status byte and a 14-bit value split into LSB and MSB */
+#define FAST_EVENT_VALUE14 5
+/** A pitch bend message, a signed value is centered at 0x2000 */
+#define FAST_EVENT_PITCHBEND 6
+
+/**
+ * A conversion rule for a single Alsa event type.
+ *
+ * :since: v0.2
+ */
+typedef struct fast_event_rule {
+    /** A status byte, a channel is added to channel messages */
+    unsigned char status;
+    /** A conversion kind, one of FAST_EVENT_* values */
+    unsigned char kind;
+} fast_event_rule;
+
+/**
+ * Conversion rules indexed by an Alsa event type.
+ * Types without a rule are decoded with snd_midi_event_decode.
+ *
+ * :since: v0.2
+ */
+static const fast_event_rule fast_event_rules[256] = {
+    [SND_SEQ_EVENT_NOTEON]       = { 0x90, FAST_EVENT_NOTE },
+    [SND_SEQ_EVENT_NOTEOFF]      = { 0x80, FAST_EVENT_NOTE },
+    [SND_SEQ_EVENT_KEYPRESS]     = { 0xA0, FAST_EVENT_NOTE },
+    [SND_SEQ_EVENT_CONTROLLER]   = { 0xB0, FAST_EVENT_CONTROL },
+    [SND_SEQ_EVENT_PGMCHANGE]    = { 0xC0, FAST_EVENT_VALUE },
+    [SND_SEQ_EVENT_CHANPRESS]    = { 0xD0, FAST_EVENT_VALUE },
+    [SND_SEQ_EVENT_PITCHBEND]    = { 0xE0, FAST_EVENT_PITCHBEND },
+    [SND_SEQ_EVENT_QFRAME]       = { 0xF1, FAST_EVENT_VALUE },
+    [SND_SEQ_EVENT_SONGPOS]      = { 0xF2, FAST_EVENT_VALUE14 },
+    [SND_SEQ_EVENT_SONGSEL]      = { 0xF3, FAST_EVENT_VALUE },
+    [SND_SEQ_EVENT_TUNE_REQUEST] = { 0xF6, FAST_EVENT_STATUS },
+    [SND_SEQ_EVENT_CLOCK]        = { 0xF8, FAST_EVENT_STATUS },
+    [SND_SEQ_EVENT_TICK]         = { 0xF9, FAST_EVENT_STATUS },
+    [SND_SEQ_EVENT_START]        = { 0xFA, FAST_EVENT_STATUS },
+    [SND_SEQ_EVENT_CONTINUE]     = { 0xFB, FAST_EVENT_STATUS },
+    [SND_SEQ_EVENT_STOP]         = { 0xFC, FAST_EVENT_STATUS },
+    [SND_SEQ_EVENT_SENSING]      = { 0xFE, FAST_EVENT_STATUS },
+    [SND_SEQ_EVENT_RESET]        = { 0xFF, FAST_EVENT_STATUS },
+};
+
+/**
+ * Converts channel voice, system common and realtime Alsa events to MIDI bytes
+ * without a snd_midi_event_t parser. Produces the same bytes as snd_midi_event_decode
+ * with running status disabled.
+ *
+ * :param ev: an Alsa sequencer event
+ * :param buf: a buffer of at least 3 bytes
+ *
+ * :returns: an amount of written bytes, **0** if the event type has no fast path
+ *
+ * :since: v0.2
+ */
+long decode_alsa_event_fast(const snd_seq_event_t * ev, unsigned char * buf) {
+    const fast_event_rule * rule = &fast_event_rules[(unsigned char) ev->type];
+    unsigned char channel = ev->data.control.channel & 0x0F;
+    int value;
+    switch (rule->kind) {
+    case FAST_EVENT_STATUS:
+        buf[0] = rule->status;
+        return 1;
+    case FAST_EVENT_NOTE:
+        buf[0] = rule->status | (ev->data.note.channel & 0x0F);
+        buf[1] = ev->data.note.note & 0x7F;
+        buf[2] = ev->data.note.velocity & 0x7F;
+        return 3;
+    case FAST_EVENT_CONTROL:
+        buf[0] = rule->status | channel;
+        buf[1] = ev->data.control.param & 0x7F;
+        buf[2] = ev->data.control.value & 0x7F;
+        return 3;
+    case FAST_EVENT_VALUE:
+        // System common messages have no channel
+        buf[0] = rule->status < 0xF0 ? rule->status | channel : rule->status;
+        buf[1] = ev->data.control.value & 0x7F;
+        return 2;
+    case FAST_EVENT_VALUE14:
+        buf[0] = rule->status;
+        buf[1] = ev->data.control.value & 0x7F;
+        buf[2] = (ev->data.control.value >> 7) & 0x7F;
+        return 3;
+    case FAST_EVENT_PITCHBEND:
+        value = ev->data.control.value + 8192;
+        buf[0] = rule->status | channel;
+        buf[1] = value & 0x7F;
+        buf[2] = (value >> 7) & 0x7F;
+        return 3;
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,330 @@
+/**
+ * Fan-out of one input port to many independent consumers
+ */
+
+/** A maximal amount of consumers of a single input port */
+#define MIDI_MAX_CONSUMERS 8
+/** A default amount of slots of a consumer ring */
+#define CONSUMER_RING_SIZE 1024
+
+/**
+ * An immutable SysEx payload shared by all consumers that received it.
+ * The input thread copies bytes once, every consumer holds a reference
+ * and drops it with :c:func:`release_shared_payload`, the last one frees memory.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_shared_payload {
+    /** An amount of holders */
+    atomic_uint refs;
+    /** Length of bytes */
+    uint32_t count;
+    /** Message bytes */
+    unsigned char bytes[];
+} MIDI_shared_payload;
+
+/**
+ * An item of a consumer ring.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_fan_out_event {
+    /** An event, SysEx and long events only have a length inline */
+    MIDI_event event;
+    /** A payload when a :c:data:`MIDI_EVENT_PAYLOAD` flag is set, **NULL** otherwise.
+        A reader owns a reference and releases it with :c:func:`release_shared_payload` */
+    MIDI_shared_payload * sysex;
+} MIDI_fan_out_event;
+
+/**
+ * A consumer of an input port with its own ring, read position and overflow policy,
+ * added with :c:func:`add_midi_consumer`. The input thread is the only producer,
+ * a single consumer thread reads it, so consumers never wait for each other.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_consumer {
+    /** A lock-free ring of :c:type:`MIDI_fan_out_event` values */
+    MIDI_ring_buffer * ring;
+    /** What the input thread does when this ring is full,
+        :c:member:`overflow_policy_t.OP_COALESCE` is not supported */
+    overflow_policy_t overflow_policy;
+    /** Set by :c:func:`close_midi_consumer`, the input thread skips a closed consumer */
+    atomic_bool closed;
+    /** Messages dropped because this ring was full */
+    atomic_ulong drops;
+    /** An eventfd signalled when events are published, **-1** if unavailable */
+    int wakeup_fd;
+    /** Set when wakeup_fd was signalled and not cleared yet */
+    atomic_bool wakeup_pending;
+    /** Signalled when this consumer reads events, wakes the input thread
+        waiting with :c:member:`overflow_policy_t.OP_BLOCK` */
+    MIDI_room_signal room;
+} MIDI_consumer;
+
+/**
+ * Consumers of an input port, used with :c:member:`RMR_Port_config.fan_out`.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_fan_out {
+    /** Consumer slots, the first count ones are used */
+    MIDI_consumer consumers[MIDI_MAX_CONSUMERS];
+    /** An amount of added consumers, a slot is filled before it is counted */
+    atomic_uint count;
+} MIDI_fan_out;
+
+/**
+ * Copies bytes to a new :c:type:`MIDI_shared_payload` instance held by the caller.
+ *
+ * :param buf: message bytes
+ * :param count: length of buf
+ *
+ * :returns: a payload with a single reference or **NULL** on an error
+ *
+ * :since: v0.2
+ */
+MIDI_shared_payload * new_shared_payload(const unsigned char * buf, long count) {
+    MIDI_shared_payload * payload = malloc(sizeof(MIDI_shared_payload) + count);
+    if (payload == NULL) return NULL;
+    atomic_init(&payload->refs, 1);
+    payload->count = (uint32_t) count;
+    memcpy(payload->bytes, buf, count);
+    return payload;
+}
+
+/**
+ * Adds a holder of a payload.
+ *
+ * :param payload: a :c:type:`MIDI_shared_payload` instance
+ *
+ * :since: v0.2
+ */
+void retain_shared_payload(MIDI_shared_payload * payload) {
+    // A new holder gets a payload through a ring, publication orders it
+    atomic_fetch_add_explicit(&payload->refs, 1, memory_order_relaxed);
+}
+
+/**
+ * Drops a reference to a payload, the last holder frees it.
+ *
+ * :param payload: a :c:type:`MIDI_shared_payload` instance or **NULL**
+ *
+ * :since: v0.2
+ */
+void release_shared_payload(MIDI_shared_payload * payload) {
+    if (payload == NULL) return;
+    if (atomic_fetch_sub_explicit(&payload->refs, 1, memory_order_acq_rel) == 1) free(payload);
+}
+
+/**
+ * Allocates an empty :c:type:`MIDI_fan_out` instance.
+ *
+ * :param fan_out: a double pointer used to allocate memory for a :c:type:`MIDI_fan_out` instance
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int init_fan_out(MIDI_fan_out ** fan_out) {
+    int result = 0;
+    // All-zero bytes are a valid initial state of atomic integers
+    * fan_out = calloc(1, sizeof(MIDI_fan_out));
+    if (* fan_out == NULL) result = -1;
+    return result;
+}
+
+/**
+ * Deallocates a :c:type:`MIDI_fan_out` instance, its rings and unread payloads.
+ * Called after the input thread is stopped and consumers are done.
+ *
+ * :param fan_out: a :c:type:`MIDI_fan_out` instance or **NULL**
+ *
+ * :since: v0.2
+ */
+void free_fan_out(MIDI_fan_out * fan_out) {
+    MIDI_fan_out_event item;
+    if (fan_out == NULL) return;
+    unsigned int count = atomic_load(&fan_out->count);
+    for (unsigned int consumer_idx = 0; consumer_idx < count; consumer_idx++) {
+        MIDI_consumer * consumer = &fan_out->consumers[consumer_idx];
+        while (ring_buffer_pop(consumer->ring, &item)) release_shared_payload(item.sysex);
+        free_ring_buffer(consumer->ring);
+        if (consumer->wakeup_fd >= 0) close(consumer->wakeup_fd);
+        free_room_signal(&consumer->room);
+    }
+    free(fan_out);
+}
+
+/**
+ * Adds a consumer slot. Called from a single control thread,
+ * the input thread sees a consumer once it is ready.
+ *
+ * :param fan_out: a :c:type:`MIDI_fan_out` instance
+ * :param ring_size: an amount of ring slots, rounded up to a power of two
+ * :param overflow_policy: what to do when a ring is full
+ * :param consumer: a double pointer set to an added :c:type:`MIDI_consumer` instance
+ *
+ * :returns: **0** on success, **-1** when consumers are full, a policy is
+ *           :c:member:`overflow_policy_t.OP_COALESCE` or memory can't be allocated
+ *
+ * :since: v0.2
+ */
+int add_fan_out_consumer(
+    MIDI_fan_out * fan_out,
+    size_t ring_size,
+    overflow_policy_t overflow_policy,
+    MIDI_consumer ** consumer
+  ) {
+    int result = 0;
+    * consumer = NULL;
+    do {
+        unsigned int count = atomic_load_explicit(&fan_out->count, memory_order_relaxed);
+        if (count == MIDI_MAX_CONSUMERS || overflow_policy == OP_COALESCE) {
+            result = -1;
+            break;
+        }
+        MIDI_consumer * added = &fan_out->consumers[count];
+        if (init_ring_buffer(&added->ring, ring_size, sizeof(MIDI_fan_out_event)) != 0) {
+            result = -1;
+            break;
+        }
+        if (overflow_policy == OP_DROP_OLDEST && ring_buffer_enable_discard(added->ring) != 0) {
+            free_ring_buffer(added->ring);
+            added->ring = NULL;
+            result = -1;
+            break;
+        }
+        added->overflow_policy = overflow_policy;
+        atomic_init(&added->closed, false);
+        atomic_init(&added->drops, 0);
+        atomic_init(&added->wakeup_pending, false);
+        added->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        init_room_signal(&added->room);
+        // A slot is ready before the input thread can see it
+        atomic_store_explicit(&fan_out->count, count + 1, memory_order_release);
+        * consumer = added;
+    } while (0);
+    return result;
+}
+
+/**
+ * Makes pushed events of every consumer visible and signals consumers that got them.
+ * Called from the input thread only.
+ *
+ * :param fan_out: a :c:type:`MIDI_fan_out` instance
+ * :param signal: signal consumer descriptors, **false** in a threadless mode
+ *
+ * :since: v0.2
+ */
+void publish_fan_out(MIDI_fan_out * fan_out, bool signal) {
+    unsigned int count = atomic_load_explicit(&fan_out->count, memory_order_acquire);
+    for (unsigned int consumer_idx = 0; consumer_idx < count; consumer_idx++) {
+        MIDI_consumer * consumer = &fan_out->consumers[consumer_idx];
+        // Only the producer writes a head, so a relaxed load is enough
+        if (consumer->ring->head_pending == atomic_load_explicit(&consumer->ring->head, memory_order_relaxed))
+            continue;
+        ring_buffer_publish(consumer->ring);
+        if (!signal || consumer->wakeup_fd < 0) continue;
+        if (atomic_exchange(&consumer->wakeup_pending, true)) continue;
+        uint64_t one = 1;
+        int res = write(consumer->wakeup_fd, &one, sizeof(one));
+        (void) res;
+    }
+}
+
+/**
+ * Reads the oldest event of a consumer without blocking. Called from a consumer thread.
+ *
+ * :param consumer: a :c:type:`MIDI_consumer` instance
+ * :param event: a :c:type:`MIDI_event` instance to fill
+ * :param sysex: set to a SysEx payload the caller has to release with
+ *               :c:func:`release_shared_payload`, **NULL** for other events
+ *
+ * :returns: **true** when an event was read
+ *
+ * :since: v0.2
+ */
+bool pop_consumer_event(MIDI_consumer * consumer, MIDI_event * event, MIDI_shared_payload ** sysex) {
+    MIDI_fan_out_event item;
+    if (!ring_buffer_pop(consumer->ring, &item)) return false;
+    * event = item.event;
+    * sysex = item.sysex;
+    signal_room(&consumer->room);
+    return true;
+}
+
+/**
+ * Reads up to **max** oldest events of a consumer with a single position update.
+ * Called from a consumer thread.
+ *
+ * :param consumer: a :c:type:`MIDI_consumer` instance
+ * :param items: an array of at least **max** :c:type:`MIDI_fan_out_event` instances to fill,
+ *               the caller releases their SysEx payloads
+ * :param max: a maximal amount of events to read
+ *
+ * :returns: an amount of events read
+ *
+ * :since: v0.2
+ */
+size_t pop_consumer_events(MIDI_consumer * consumer, MIDI_fan_out_event * items, size_t max) {
+    size_t count = ring_buffer_pop_batch(consumer->ring, items, max);
+    if (count > 0) signal_room(&consumer->room);
+    return count;
+}
+
+/**
+ * Returns a descriptor that becomes readable when a consumer gets events.
+ *
+ * :param consumer: a :c:type:`MIDI_consumer` instance
+ *
+ * :returns: an eventfd descriptor or **-1** when it is unavailable
+ *
+ * :since: v0.2
+ */
+int get_consumer_fd(MIDI_consumer * consumer) {
+    return consumer->wakeup_fd;
+}
+
+/**
+ * Clears a signalled consumer descriptor, called before reading a ring.
+ *
+ * :param consumer: a :c:type:`MIDI_consumer` instance
+ *
+ * :since: v0.2
+ */
+void clear_consumer_wakeup(MIDI_consumer * consumer) {
+    uint64_t value;
+    if (consumer->wakeup_fd < 0) return;
+    // Read a counter first, so a signal sent in between is never lost
+    int res = read(consumer->wakeup_fd, &value, sizeof(value));
+    (void) res;
+    atomic_store(&consumer->wakeup_pending, false);
+}
+
+/**
+ * Stops passing events to a consumer, unread events stay in its ring
+ * until :c:func:`free_fan_out`. A slot is not reused.
+ *
+ * :param consumer: a :c:type:`MIDI_consumer` instance
+ *
+ * :since: v0.2
+ */
+void close_midi_consumer(MIDI_consumer * consumer) {
+    atomic_store(&consumer->closed, true);
+    // The input thread may wait for room in this ring
+    signal_room(&consumer->room);
+}
+
+/**
+ * Returns an amount of messages dropped because a consumer ring was full.
+ *
+ * :param consumer: a :c:type:`MIDI_consumer` instance
+ *
+ * :returns: an amount of dropped messages
+ *
+ * :since: v0.2
+ */
+unsigned long get_consumer_drops(MIDI_consumer * consumer) {
+    return atomic_load_explicit(&consumer->drops, memory_order_relaxed);
+}
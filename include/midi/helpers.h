@@ -1,4 +1,6 @@
 #include <glib.h>
+#include <stdint.h>
+#include <time.h>
 
 /**
  * Helper functions
@@ -19,3 +21,16 @@ unsigned char get_last_bytearray_byte(GArray * bytearray) {
         result = g_array_index(bytearray, unsigned char, bytearray->len - 1);
     return result;
 }
+
+/**
+ * Read a CLOCK_MONOTONIC clock
+ *
+ * :returns: current monotonic time in nanoseconds
+ *
+ * :since: v0.2
+ */
+uint64_t get_monotonic_time_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
@@ -0,0 +1,267 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Input filters, evaluated for every Alsa event before it is decoded
+ */
+
+/** A maximal amount of accepted senders of a filter */
+#define MIDI_FILTER_MAX_SOURCES 16
+/** All channels of a channel mask */
+#define MIDI_FILTER_ALL_CHANNELS 0xFFFF
+/** All message types of a type mask */
+#define MIDI_FILTER_ALL_TYPES ((1u << MF_TYPE_COUNT) - 1)
+
+/** A compiled rule bit: an event type without a channel is accepted */
+#define MIDI_FILTER_ACCEPT (1u << 16)
+/** A compiled rule bit: a note number has to be in an accepted range */
+#define MIDI_FILTER_NOTES (1u << 17)
+/** A compiled rule bit: a controller number has to be in an accepted range */
+#define MIDI_FILTER_CONTROLLERS (1u << 18)
+
+/**
+ * Messages accepted by an input port, set in :c:member:`RMR_Port_config.filter`.
+ * A message is accepted when all conditions are met.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_filter_config {
+    /** Accepted message types, bit N accepts :c:type:`mf_type_t` value N */
+    uint32_t types;
+    /** Accepted channels of channel messages indexed by :c:type:`mf_type_t`,
+        bit N accepts channel N, counting from 0 */
+    uint16_t channels[MF_PITCH_BEND + 1];
+    /** The lowest accepted note of note and key pressure messages */
+    unsigned char note_min;
+    /** The highest accepted note of note and key pressure messages */
+    unsigned char note_max;
+    /** The lowest accepted controller of control change messages */
+    unsigned char controller_min;
+    /** The highest accepted controller of control change messages */
+    unsigned char controller_max;
+    /** Accepted senders, checked when source_count is not zero */
+    snd_seq_addr_t sources[MIDI_FILTER_MAX_SOURCES];
+    /** An amount of accepted senders, **0** accepts any sender */
+    unsigned int source_count;
+} MIDI_filter_config;
+
+/**
+ * A :c:type:`MIDI_filter_config` compiled to a lookup table,
+ * so an event is checked with a few loads without decoding it.
+ * A zeroed instance accepts everything.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_input_filter {
+    /** Rules indexed by an Alsa event type: accepted channels in bits 0 - 15
+        and :c:data:`MIDI_FILTER_ACCEPT`, :c:data:`MIDI_FILTER_NOTES`,
+        :c:data:`MIDI_FILTER_CONTROLLERS` bits */
+    uint32_t rules[256];
+    /** Accepted notes, bit N accepts note N */
+    uint64_t notes[2];
+    /** Accepted controllers, bit N accepts controller N */
+    uint64_t controllers[2];
+    /** Accepted senders */
+    snd_seq_addr_t sources[MIDI_FILTER_MAX_SOURCES];
+    /** An amount of accepted senders, **0** accepts any sender */
+    unsigned int source_count;
+    /** Set when a filter may reject something, otherwise checks are skipped */
+    bool active;
+} MIDI_input_filter;
+
+/**
+ * Sets a filter configuration that accepts all messages.
+ *
+ * :param config: a :c:type:`MIDI_filter_config` instance
+ *
+ * :since: v0.2
+ */
+void reset_midi_filter_config(MIDI_filter_config * config) {
+    config->types = MIDI_FILTER_ALL_TYPES;
+    for (int type_idx = 0; type_idx <= MF_PITCH_BEND; type_idx++)
+        config->channels[type_idx] = MIDI_FILTER_ALL_CHANNELS;
+    config->note_min = 0;
+    config->note_max = 127;
+    config->controller_min = 0;
+    config->controller_max = 127;
+    config->source_count = 0;
+}
+
+/**
+ * Sets accepted channels of all channel messages.
+ *
+ * :param config: a :c:type:`MIDI_filter_config` instance
+ * :param channels: a channel mask, bit N accepts channel N, counting from 0
+ *
+ * :since: v0.2
+ */
+void set_midi_filter_channels(MIDI_filter_config * config, uint16_t channels) {
+    for (int type_idx = 0; type_idx <= MF_PITCH_BEND; type_idx++)
+        config->channels[type_idx] = channels;
+}
+
+/**
+ * Rejects message types like RtMidi's ignoreTypes does.
+ *
+ * :param config: a :c:type:`MIDI_filter_config` instance
+ * :param sysex: reject SysEx messages
+ * :param timing: reject time code, clock and tick messages
+ * :param sensing: reject active sensing messages
+ *
+ * :since: v0.2
+ */
+void ignore_midi_types(MIDI_filter_config * config, bool sysex, bool timing, bool sensing) {
+    if (sysex) config->types &= ~(1u << MF_SYSEX);
+    if (timing) config->types &= ~(1u << MF_TIME_CODE | 1u << MF_CLOCK | 1u << MF_TICK);
+    if (sensing) config->types &= ~(1u << MF_ACTIVE_SENSING);
+}
+
+/**
+ * Adds an accepted sender, once the first one is added others are rejected.
+ *
+ * :param config: a :c:type:`MIDI_filter_config` instance
+ * :param client: a sender client id
+ * :param port: a sender port id
+ *
+ * :returns: **0** on success, **-1** when :c:data:`MIDI_FILTER_MAX_SOURCES` senders are added already
+ *
+ * :since: v0.2
+ */
+int add_midi_filter_source(MIDI_filter_config * config, int client, int port) {
+    int result = 0;
+    if (config->source_count < MIDI_FILTER_MAX_SOURCES) {
+        config->sources[config->source_count].client = client;
+        config->sources[config->source_count].port = port;
+        config->source_count++;
+    } else {
+        result = -1;
+    }
+    return result;
+}
+
+/**
+ * Finds a filter type of a MIDI message by its status byte.
+ *
+ * :param status: a first byte of a message
+ *
+ * :returns: a :c:type:`mf_type_t` value
+ *
+ * :since: v0.2
+ */
+mf_type_t get_filter_type(unsigned char status) {
+    static const mf_type_t system_types[16] = {
+        MF_SYSEX, MF_TIME_CODE, MF_SONG_POSITION, MF_SONG_SELECT, MF_OTHER, MF_OTHER, MF_TUNE_REQUEST, MF_OTHER,
+        MF_CLOCK, MF_TICK, MF_START, MF_CONTINUE, MF_STOP, MF_OTHER, MF_ACTIVE_SENSING, MF_RESET
+    };
+    if (status < 0x80) return MF_OTHER;
+    if (status < 0xF0) return (mf_type_t) ((status >> 4) - 8);
+    return system_types[status & 0x0F];
+}
+
+/**
+ * Sets a bit range of a 128-bit set.
+ *
+ * :param bits: a set of two 64-bit words
+ * :param min: the lowest bit to set
+ * :param max: the highest bit to set
+ *
+ * :since: v0.2
+ */
+void set_filter_bit_range(uint64_t * bits, unsigned char min, unsigned char max) {
+    bits[0] = bits[1] = 0;
+    for (unsigned int bit = min; bit <= max && bit < 128; bit++) bits[bit >> 6] |= (uint64_t) 1 << (bit & 63);
+}
+
+/**
+ * Compiles a filter configuration to a lookup table.
+ * Alsa event types are mapped to MIDI message types with :c:data:`fast_event_rules`,
+ * events that decode to control changes are checked like them.
+ *
+ * :param filter: a :c:type:`MIDI_input_filter` instance to fill
+ * :param config: a :c:type:`MIDI_filter_config` instance
+ *
+ * :since: v0.2
+ */
+void compile_midi_filter(MIDI_input_filter * filter, const MIDI_filter_config * config) {
+    filter->active = false;
+    for (int ev_type = 0; ev_type < 256; ev_type++) {
+        unsigned char status = fast_event_rules[ev_type].status;
+        bool controller = false;
+        switch (ev_type) {
+        case SND_SEQ_EVENT_NOTE:
+            status = 0x90;
+            break;
+        case SND_SEQ_EVENT_CONTROL14:
+            controller = true;
+            status = 0xB0;
+            break;
+        // Parameter numbers are sent with several controllers
+        case SND_SEQ_EVENT_NONREGPARAM:
+        case SND_SEQ_EVENT_REGPARAM:
+            status = 0xB0;
+            break;
+        case SND_SEQ_EVENT_SYSEX:
+            status = 0xF0;
+            break;
+        default:
+            controller = status == 0xB0;
+            break;
+        }
+        mf_type_t msg_type = get_filter_type(status);
+        uint32_t rule = 0;
+        if (config->types & (1u << msg_type)) {
+            if (msg_type > MF_PITCH_BEND) rule = MIDI_FILTER_ACCEPT;
+            else rule = config->channels[msg_type];
+            // Ranges are only checked when they reject something
+            if (msg_type <= MF_KEY_PRESSURE && (config->note_min > 0 || config->note_max < 127))
+                rule |= MIDI_FILTER_NOTES;
+            if (controller && (config->controller_min > 0 || config->controller_max < 127))
+                rule |= MIDI_FILTER_CONTROLLERS;
+        }
+        if (rule != (msg_type <= MF_PITCH_BEND ? MIDI_FILTER_ALL_CHANNELS : MIDI_FILTER_ACCEPT))
+            filter->active = true;
+        filter->rules[ev_type] = rule;
+    }
+    set_filter_bit_range(filter->notes, config->note_min, config->note_max);
+    set_filter_bit_range(filter->controllers, config->controller_min, config->controller_max);
+    filter->source_count = config->source_count < MIDI_FILTER_MAX_SOURCES ? config->source_count : MIDI_FILTER_MAX_SOURCES;
+    for (unsigned int source_idx = 0; source_idx < filter->source_count; source_idx++)
+        filter->sources[source_idx] = config->sources[source_idx];
+    if (filter->source_count > 0) filter->active = true;
+}
+
+/**
+ * Checks if an event passes a filter. Only reads fields of an Alsa event,
+ * so rejected events are never decoded.
+ *
+ * :param filter: a compiled :c:type:`MIDI_input_filter` instance
+ * :param ev: an Alsa sequencer event
+ *
+ * :returns: **true** when an event is accepted
+ *
+ * :since: v0.2
+ */
+bool accept_alsa_event(const MIDI_input_filter * filter, const snd_seq_event_t * ev) {
+    if (!filter->active) return true;
+    uint32_t rule = filter->rules[(unsigned char) ev->type];
+    // Note and control events keep a channel in the same place
+    if (rule & MIDI_FILTER_ALL_CHANNELS) {
+        if (!(rule & (1u << (ev->data.note.channel & 0x0F)))) return false;
+        unsigned int note = ev->data.note.note & 0x7F;
+        if ((rule & MIDI_FILTER_NOTES) && !(filter->notes[note >> 6] & ((uint64_t) 1 << (note & 63))))
+            return false;
+        unsigned int controller = ev->data.control.param & 0x7F;
+        if ((rule & MIDI_FILTER_CONTROLLERS) && !(filter->controllers[controller >> 6] & ((uint64_t) 1 << (controller & 63))))
+            return false;
+    } else if (!(rule & MIDI_FILTER_ACCEPT)) {
+        return false;
+    }
+    if (filter->source_count == 0) return true;
+    for (unsigned int source_idx = 0; source_idx < filter->source_count; source_idx++) {
+        if (
+            filter->sources[source_idx].client == ev->source.client &&
+            filter->sources[source_idx].port == ev->source.port
+        ) return true;
+    }
+    return false;
+}
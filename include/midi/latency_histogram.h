@@ -0,0 +1,205 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Lock-free log-linear latency histogram
+ */
+
+/** Sub-buckets per power of two are 2^N, so a bucket is at most 1/8 of its value wide */
+#define LATENCY_SUB_BUCKET_BITS 3
+/** An amount of sub-buckets per power of two */
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+/** An amount of buckets covering the whole uint64_t range */
+#define LATENCY_BUCKET_COUNT ((64 - LATENCY_SUB_BUCKET_BITS + 1) << LATENCY_SUB_BUCKET_BITS)
+
+/**
+ * A histogram of latencies in nanoseconds.
+ *
+ * Values below :c:data:`LATENCY_SUB_BUCKETS` have their own buckets,
+ * every following power of two is split into :c:data:`LATENCY_SUB_BUCKETS` equal buckets,
+ * so percentiles are precise to 12.5% for any value with a fixed amount of memory.
+ * Any thread can record values and read a histogram, nothing is locked.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_latency_histogram {
+    /** Amounts of recorded values, look at :c:func:`get_latency_bucket` */
+    atomic_ulong buckets[LATENCY_BUCKET_COUNT];
+    /** An amount of recorded values */
+    atomic_ulong count;
+    /** A sum of recorded values, used for a mean value */
+    atomic_ulong sum_ns;
+    /** A maximal recorded value */
+    atomic_ulong max_ns;
+} MIDI_latency_histogram;
+
+/**
+ * Allocates a :c:type:`MIDI_latency_histogram` instance with empty buckets.
+ *
+ * :param histogram: a double pointer used to allocate memory for a :c:type:`MIDI_latency_histogram` instance
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int init_latency_histogram(MIDI_latency_histogram ** histogram) {
+    int result = 0;
+    // All-zero bytes are a valid initial state of atomic integers
+    * histogram = calloc(1, sizeof(MIDI_latency_histogram));
+    if (* histogram == NULL) result = -1;
+    return result;
+}
+
+/**
+ * Deallocates a :c:type:`MIDI_latency_histogram` instance.
+ *
+ * :param histogram: a :c:type:`MIDI_latency_histogram` instance
+ *
+ * :since: v0.2
+ */
+void free_latency_histogram(MIDI_latency_histogram * histogram) {
+    free(histogram);
+}
+
+/**
+ * Finds a bucket of a value.
+ *
+ * :param value: a latency in nanoseconds
+ *
+ * :returns: a bucket index, less than :c:data:`LATENCY_BUCKET_COUNT`
+ *
+ * :since: v0.2
+ */
+unsigned int get_latency_bucket(uint64_t value) {
+    if (value < LATENCY_SUB_BUCKETS) return (unsigned int) value;
+    unsigned int msb = 63 - __builtin_clzll(value);
+    unsigned int shift = msb - LATENCY_SUB_BUCKET_BITS;
+    // A power of two selects a group, bits after the highest one select a bucket in it
+    return ((shift + 1) << LATENCY_SUB_BUCKET_BITS) | ((value >> shift) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+/**
+ * Finds the lowest value of a bucket.
+ *
+ * :param bucket: a bucket index
+ *
+ * :returns: the lowest value in nanoseconds that falls into a bucket
+ *
+ * :since: v0.2
+ */
+uint64_t get_latency_bucket_floor(unsigned int bucket) {
+    if (bucket < LATENCY_SUB_BUCKETS) return bucket;
+    unsigned int shift = (bucket >> LATENCY_SUB_BUCKET_BITS) - 1;
+    return (uint64_t) (LATENCY_SUB_BUCKETS | (bucket & (LATENCY_SUB_BUCKETS - 1))) << shift;
+}
+
+/**
+ * Adds a value to a histogram.
+ *
+ * :param histogram: a :c:type:`MIDI_latency_histogram` instance
+ * :param value: a latency in nanoseconds
+ *
+ * :since: v0.2
+ */
+void record_latency(MIDI_latency_histogram * histogram, uint64_t value) {
+    atomic_fetch_add_explicit(&histogram->buckets[get_latency_bucket(value)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum_ns, value, memory_order_relaxed);
+    unsigned long max = atomic_load_explicit(&histogram->max_ns, memory_order_relaxed);
+    // A failed exchange reloads max, so the loop ends once a bigger value is stored by anyone
+    while (value > max && !atomic_compare_exchange_weak_explicit(
+        &histogram->max_ns, &max, value, memory_order_relaxed, memory_order_relaxed
+    ));
+}
+
+/**
+ * Finds a value below which a given share of recorded values falls.
+ * Returns an upper bound of a bucket, so a result is never lower than an exact percentile
+ * and never higher than a maximal recorded value.
+ *
+ * :param histogram: a :c:type:`MIDI_latency_histogram` instance
+ * :param percentile: a share of values from **0.0** to **100.0**, for example, **99.0**
+ *
+ * :returns: a latency in nanoseconds, **0** when a histogram is empty
+ *
+ * :since: v0.2
+ */
+uint64_t get_latency_percentile(MIDI_latency_histogram * histogram, double percentile) {
+    unsigned long counts[LATENCY_BUCKET_COUNT];
+    unsigned long total = 0;
+    // Buckets are copied first, so concurrent records don't move a target
+    for (unsigned int bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++) {
+        counts[bucket] = atomic_load_explicit(&histogram->buckets[bucket], memory_order_relaxed);
+        total += counts[bucket];
+    }
+    if (total == 0) return 0;
+    uint64_t max = atomic_load_explicit(&histogram->max_ns, memory_order_relaxed);
+    unsigned long target = (unsigned long) (percentile / 100.0 * total + 0.5);
+    if (target == 0) target = 1;
+    unsigned long seen = 0;
+    for (unsigned int bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++) {
+        seen += counts[bucket];
+        if (seen < target) continue;
+        if (bucket + 1 == LATENCY_BUCKET_COUNT) return max;
+        uint64_t upper = get_latency_bucket_floor(bucket + 1) - 1;
+        return upper < max ? upper : max;
+    }
+    return max;
+}
+
+/**
+ * Returns an amount of recorded values.
+ *
+ * :param histogram: a :c:type:`MIDI_latency_histogram` instance
+ *
+ * :returns: an amount of values
+ *
+ * :since: v0.2
+ */
+unsigned long get_latency_count(MIDI_latency_histogram * histogram) {
+    return atomic_load_explicit(&histogram->count, memory_order_relaxed);
+}
+
+/**
+ * Returns a mean of recorded values.
+ *
+ * :param histogram: a :c:type:`MIDI_latency_histogram` instance
+ *
+ * :returns: a mean latency in nanoseconds, **0** when a histogram is empty
+ *
+ * :since: v0.2
+ */
+uint64_t get_latency_mean(MIDI_latency_histogram * histogram) {
+    unsigned long count = atomic_load_explicit(&histogram->count, memory_order_relaxed);
+    if (count == 0) return 0;
+    return atomic_load_explicit(&histogram->sum_ns, memory_order_relaxed) / count;
+}
+
+/**
+ * Returns a maximal recorded value.
+ *
+ * :param histogram: a :c:type:`MIDI_latency_histogram` instance
+ *
+ * :returns: a maximal latency in nanoseconds
+ *
+ * :since: v0.2
+ */
+uint64_t get_latency_max(MIDI_latency_histogram * histogram) {
+    return atomic_load_explicit(&histogram->max_ns, memory_order_relaxed);
+}
+
+/**
+ * Empties a histogram. Values recorded concurrently may be partially kept.
+ *
+ * :param histogram: a :c:type:`MIDI_latency_histogram` instance
+ *
+ * :since: v0.2
+ */
+void reset_latency_histogram(MIDI_latency_histogram * histogram) {
+    for (unsigned int bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++)
+        atomic_store_explicit(&histogram->buckets[bucket], 0, memory_order_relaxed);
+    atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&histogram->sum_ns, 0, memory_order_relaxed);
+    atomic_store_explicit(&histogram->max_ns, 0, memory_order_relaxed);
+}
@@ -0,0 +1,174 @@
+/**
+ * Preallocated MIDI message pool
+ */
+
+/**
+ * A slot of a :c:type:`MIDI_message_pool` free list.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_pool_slot {
+    /** A position a slot is ready for: a returned message is put at an equal position,
+        a message is taken at a position one less */
+    atomic_size_t sequence;
+    /** A free message, valid when a slot is ready to be taken from */
+    MIDI_message * message;
+} MIDI_pool_slot;
+
+/**
+ * A fixed set of :c:type:`MIDI_message` instances with preallocated payloads.
+ *
+ * The input thread takes messages from a pool, consumers return them
+ * with :c:func:`free_midi_message`. Free messages are kept in a bounded
+ * multi-producer / single-consumer ring: the input thread is its only reader,
+ * any thread may return a message, claiming a slot with compare-and-swap;
+ * neither side takes a lock.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_message_pool {
+    /** Next free list position the input thread takes a message from */
+    _Alignas(RING_BUFFER_CACHE_LINE) size_t take_position;
+    /** Next free list position a returned message is put at, shared by returning threads */
+    _Alignas(RING_BUFFER_CACHE_LINE) atomic_size_t return_position;
+    /** Free list slots, a power of two not smaller than message_count */
+    _Alignas(RING_BUFFER_CACHE_LINE) MIDI_pool_slot * free_slots;
+    /** Amount of free list slots - 1, used to wrap positions */
+    size_t slot_mask;
+    /** Preallocated messages */
+    MIDI_message * messages;
+    /** Payload storage, message_count * payload_size bytes */
+    unsigned char * payloads;
+    /** Amount of messages in a pool */
+    size_t message_count;
+    /** Payload capacity of a single message in bytes */
+    size_t payload_size;
+} MIDI_message_pool;
+
+/**
+ * Deallocates a :c:type:`MIDI_message_pool` instance with all its messages.
+ * Messages taken from a pool are invalid after this call.
+ *
+ * :param pool: a :c:type:`MIDI_message_pool` instance
+ *
+ * :since: v0.2
+ */
+void free_message_pool(MIDI_message_pool * pool) {
+    if (pool == NULL) return;
+    free(pool->free_slots);
+    free(pool->payloads);
+    free(pool->messages);
+    free(pool);
+}
+
+/**
+ * Allocates a :c:type:`MIDI_message_pool` instance, its messages and payloads.
+ *
+ * :param pool: a double pointer used to allocate memory for a :c:type:`MIDI_message_pool` instance
+ * :param message_count: an amount of messages to preallocate
+ * :param payload_size: a payload capacity of a single message in bytes
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int init_message_pool(MIDI_message_pool ** pool, size_t message_count, size_t payload_size) {
+    int result = 0;
+    size_t slot_count = 1;
+    * pool = NULL;
+    do {
+        // A larger amount has no power of two in size_t
+        if (message_count == 0 || payload_size == 0 || message_count > ((size_t) -1 >> 1) + 1) {
+            result = -1;
+            break;
+        }
+        while (slot_count < message_count) slot_count <<= 1;
+        // Positions are padded to cache lines, so the struct itself has to be aligned
+        * pool = aligned_alloc(RING_BUFFER_CACHE_LINE, sizeof(MIDI_message_pool));
+        if (* pool == NULL) {
+            result = -1;
+            break;
+        }
+        memset(* pool, 0, sizeof(MIDI_message_pool));
+        (* pool)->message_count = message_count;
+        (* pool)->payload_size = payload_size;
+        (* pool)->slot_mask = slot_count - 1;
+        (* pool)->messages = calloc(message_count, sizeof(MIDI_message));
+        (* pool)->payloads = calloc(message_count, payload_size);
+        (* pool)->free_slots = calloc(slot_count, sizeof(MIDI_pool_slot));
+        if ((* pool)->messages == NULL || (* pool)->payloads == NULL || (* pool)->free_slots == NULL) {
+            free_message_pool(* pool);
+            * pool = NULL;
+            result = -1;
+            break;
+        }
+        // Bind every message to its payload and mark it as free, other slots wait for returns
+        for (size_t slot_idx = 0; slot_idx < slot_count; slot_idx++) {
+            MIDI_pool_slot * slot = &(* pool)->free_slots[slot_idx];
+            if (slot_idx < message_count) {
+                slot->message = &(* pool)->messages[slot_idx];
+                slot->message->buf = (* pool)->payloads + slot_idx * payload_size;
+                slot->message->pool = * pool;
+                atomic_init(&slot->sequence, slot_idx + 1);
+            } else {
+                atomic_init(&slot->sequence, slot_idx);
+            }
+        }
+        (* pool)->take_position = 0;
+        atomic_init(&(* pool)->return_position, message_count);
+    } while (0);
+    return result;
+}
+
+/**
+ * Takes a free message able to hold **count** bytes from a pool.
+ * Called from the input thread only.
+ *
+ * :param pool: a :c:type:`MIDI_message_pool` instance
+ * :param count: a required payload size in bytes
+ *
+ * :returns: a :c:type:`MIDI_message` pointer or **NULL** when a pool is empty
+ *           or a payload doesn't fit
+ *
+ * :since: v0.2
+ */
+MIDI_message * take_pooled_message(MIDI_message_pool * pool, long count) {
+    if ((size_t) count > pool->payload_size) return NULL;
+    size_t position = pool->take_position;
+    MIDI_pool_slot * slot = &pool->free_slots[position & pool->slot_mask];
+    // A slot claimed by a returning thread is only ready once its message is stored
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != position + 1) return NULL;
+    MIDI_message * message = slot->message;
+    // A slot is ready for a return one lap later
+    atomic_store_explicit(&slot->sequence, position + pool->slot_mask + 1, memory_order_release);
+    pool->take_position = position + 1;
+    message->count = count;
+    return message;
+}
+
+/**
+ * Returns a message to its pool. Can be called from any thread,
+ * several threads may return messages at once.
+ *
+ * :param message: a :c:type:`MIDI_message` taken with :c:func:`take_pooled_message`
+ *
+ * :since: v0.2
+ */
+void return_pooled_message(MIDI_message * message) {
+    MIDI_message_pool * pool = message->pool;
+    size_t position = atomic_load_explicit(&pool->return_position, memory_order_relaxed);
+    MIDI_pool_slot * slot;
+    while (1) {
+        slot = &pool->free_slots[position & pool->slot_mask];
+        ptrdiff_t lag = (ptrdiff_t) (atomic_load_explicit(&slot->sequence, memory_order_acquire) - position);
+        // Slots hold every message of a pool, only a message returned twice finds a slot taken
+        if (lag < 0) return;
+        if (lag == 0 && atomic_compare_exchange_weak_explicit(
+            &pool->return_position, &position, position + 1, memory_order_relaxed, memory_order_relaxed
+        )) break;
+        // Another thread claimed a slot first
+        if (lag > 0) position = atomic_load_explicit(&pool->return_position, memory_order_relaxed);
+    }
+    slot->message = message;
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+}
@@ -1,13 +1,29 @@
 #include <pthread.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <sys/time.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sched.h>
+#include <poll.h>
+#include <unistd.h>
 #include <glib.h>
 #include "asoundlib.h"
 // C-related helpers, unrelated to core structures
 #include "helpers.h"
 // MIDI-related structures
 #include "midi_structures.h"
+// Preallocated message pool
+#include "message_pool.h"
+// Latest-value-wins storage of continuous controllers
+#include "coalescing.h"
+// Lock-free state of 16 channels
+#include "channel_state.h"
+// Many consumers of one input port
+#include "fan_out.h"
+// Callbacks running outside of the input thread
+#include "callback_pool.h"
 // Logging utilities
 #include "logging.h"
 // Error handling utilities
@@ -23,6 +39,18 @@
 #define QUEUE_TEMPO 600000
 /** A constant that defines the base resolution of the ticks (pulses per quarter note) */
 #define QUEUE_STATUS_PPQ 240
+/** A default amount of slots for :c:member:`mq_type_t.MQ_RING_BUFFER` input queues */
+#define RING_BUFFER_SIZE 1024
+/** A default payload capacity of a pooled message, fits any channel, system common or realtime message */
+#define POOL_MESSAGE_SIZE 16
+/** A default amount of SysEx payload slots for :c:member:`mq_type_t.MQ_EVENT_RING` input queues */
+#define SYSEX_RING_SIZE 64
+/** A default amount of realtime lane slots, look at :c:member:`RMR_Port_config.priority_lanes` */
+#define REALTIME_RING_SIZE 256
+/** An interval in microseconds between ring buffer checks while waiting for input */
+#define RING_BUFFER_WAIT_INTERVAL 100
+/** An interval in milliseconds between attempts to queue parked events */
+#define PARKED_EVENTS_RETRY_INTERVAL 1
 
 /**
  * Allocates memory for a :c:type:`MIDI_port` instance
@@ -53,103 +81,1447 @@ void print_midi_port(MIDI_port * current_midi_port) {
 
 /**
  * Deallocates memory for :c:type:`MIDI_message` instance
+ * or returns it to its :c:type:`MIDI_message_pool`.
  *
  * :param msg: a :c:type:`MIDI_message` instance
  *
  * :since: v0.1
  */
 void free_midi_message(MIDI_message * msg) {
+    if (msg->pool) {
+        return_pooled_message(msg);
+        return;
+    }
     if (msg->buf)   g_free(msg->buf);
     g_free(msg);
 }
 
 /**
- * Allocates memory for an instance of :c:type:`Alsa_MIDI_data`
- * or throws an error
+ * Provides a :c:type:`MIDI_message` instance for **count** bytes.
+ * Takes it from a message pool when one is assigned and has a free message
+ * with enough payload capacity, allocates it on heap otherwise.
+ * Called from the input thread only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ * :param count: a payload size in bytes
+ *
+ * :returns: a :c:type:`MIDI_message` pointer, its **buf** can hold **count** bytes
+ *
+ * :since: v0.2
+ */
+MIDI_message * new_midi_message(MIDI_in_data * input_data, long count) {
+    MIDI_message * message = NULL;
+    if (input_data->spare_count > 0 && (size_t) count <= input_data->message_pool->payload_size) {
+        message = input_data->spare_messages[--input_data->spare_count];
+        message->count = count;
+    } else if (input_data->message_pool) {
+        message = take_pooled_message(input_data->message_pool, count);
+    }
+    if (message == NULL) {
+        message = g_new(MIDI_message, 1);
+        message->buf = count > 0 ? g_malloc(count) : NULL;
+        message->count = count;
+        message->pool = NULL;
+    }
+    return message;
+}
+
+/**
+ * Allocates memory for an instance of :c:type:`Alsa_MIDI_data`
+ * or throws an error
+ *
+ * :param amidi_data: a double pointer used to allocate memory for a :c:type:`Alsa_MIDI_data` instance
+ *
+ * :since: v0.1
+ */
+void init_amidi_data_instance(Alsa_MIDI_data ** amidi_data) {
+    * amidi_data = NULL;
+    * amidi_data = malloc(sizeof(Alsa_MIDI_data));
+    if (amidi_data == NULL) slog("Start", "Unable to allocate memory for Alsa_MIDI_data instance.");
+}
+
+/**
+ * Deallocates a message the input thread dropped before a consumer got it.
+ * Pooled messages are kept for :c:func:`new_midi_message`, only a consumer
+ * returns messages to a pool. Called from the input thread only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ * :param message: a :c:type:`MIDI_message` instance
+ *
+ * :since: v0.2
+ */
+void release_midi_message(MIDI_in_data * input_data, MIDI_message * message) {
+    if (message->pool == NULL) {
+        free_midi_message(message);
+        return;
+    }
+    // Can't overflow: the array has room for every message of a pool
+    input_data->spare_messages[input_data->spare_count++] = message;
+}
+
+/**
+ * Creates an assigns a MIDI message queue for a :c:type:`MIDI_in_data` instance
+ *
+ * :param input_data: a pointer containing a :c:type:`MIDI_in_data` instance for creating a :c:type:`GAsyncQueue` instance.
+ *
+ * :since: v0.1
+ */
+void assign_midi_queue(MIDI_in_data * input_data) {
+    input_data->midi_async_queue = g_async_queue_new();
+    g_async_queue_ref(input_data->midi_async_queue);
+}
+
+/**
+ * Assign :c:type:`Alsa_MIDI_data` instance to :c:type:`MIDI_in_data` instance
+ *
+ * :param input_data: :c:type:`MIDI_in_data` instance
+ * :param amidi_data: :c:type:`Alsa_MIDI_data` instance
+ *
+ * :since: v0.1
+ */
+void assign_midi_data(MIDI_in_data * input_data, Alsa_MIDI_data * amidi_data) {
+    input_data->amidi_data = amidi_data;
+}
+
+/**
+ * Checks if a callback can be set: a callback is valid
+ * and no callback of the same kind is set yet.
+ *
+ * :param already_set: a callback of the same kind is already set
+ * :param valid: a new callback is not **NULL**
+ *
+ * :returns: **0** when a callback can be set, **-1** otherwise
+ *
+ * :since: v0.2
+ */
+int check_MIDI_in_callback(bool already_set, bool valid) {
+    int result = 0;
+    do {
+        if (already_set) {
+            slog("MIDI in", "callback function is already set.");
+            result = -1;
+            break;
+        }
+        if (!valid) {
+            slog("MIDI in", "callback function value is invalid.");
+            result = -1;
+            break;
+        }
+    } while (0);
+    return result;
+}
+
+/**
+ * Sets a callback for MIDI input events.
+ * Only one of :c:func:`set_MIDI_in_callback`, :c:func:`set_MIDI_in_event_callback`
+ * and :c:func:`set_MIDI_in_lending_callback` can be used for a port.
+ *
+ * :param input_data: :c:type:`MIDI_in_data` instance
+ * :param callback: :c:type:`MIDI_callback` instance
+ * :param user_data: an optional pointer to additional data that is passed
+ *                   to the callback function whenever it is called.
+ *
+ * :returns: **0** on success, **-1** when callback is **NULL** or a callback is already set
+ *
+ * :since: v0.1
+ */
+int set_MIDI_in_callback(
+    MIDI_in_data * input_data,
+    MIDI_callback callback,
+    void *user_data
+  ) {
+    if (check_MIDI_in_callback(input_data->using_callback, callback != NULL) != 0) return -1;
+    // Configure input data
+    input_data->user_callback = callback;
+    input_data->user_data = user_data;
+    input_data->using_callback = true;
+    return 0;
+}
+
+/**
+ * Sets a callback receiving :c:type:`MIDI_event` values for MIDI input events.
+ * Short messages are passed inline, SysEx and long message payloads are lent for the duration of a call.
+ * Can't be combined with :c:func:`set_MIDI_in_callback` or :c:func:`set_MIDI_in_lending_callback`.
+ *
+ * :param input_data: :c:type:`MIDI_in_data` instance
+ * :param callback: :c:type:`MIDI_event_callback` instance
+ * :param user_data: an optional pointer to additional data that is passed
+ *                   to the callback function whenever it is called.
+ *
+ * :returns: **0** on success, **-1** when callback is **NULL** or a callback is already set
+ *
+ * :since: v0.2
+ */
+int set_MIDI_in_event_callback(
+    MIDI_in_data * input_data,
+    MIDI_event_callback callback,
+    void *user_data
+  ) {
+    if (check_MIDI_in_callback(input_data->using_callback, callback != NULL) != 0) return -1;
+    // Configure input data
+    input_data->user_event_callback = callback;
+    input_data->user_data = user_data;
+    input_data->using_callback = true;
+    return 0;
+}
+
+/**
+ * Sets a callback receiving message bytes lent from the input thread.
+ * Bytes point to an internal decoding buffer and are only valid during a call,
+ * so no memory is allocated or copied per message. Copy bytes which have to be kept.
+ * Can't be combined with :c:func:`set_MIDI_in_callback` or :c:func:`set_MIDI_in_event_callback`.
+ *
+ * :param input_data: :c:type:`MIDI_in_data` instance
+ * :param callback: :c:type:`MIDI_lending_callback` instance
+ * :param user_data: an optional pointer to additional data that is passed
+ *                   to the callback function whenever it is called.
+ *
+ * :returns: **0** on success, **-1** when callback is **NULL** or a callback is already set
+ *
+ * :since: v0.2
+ */
+int set_MIDI_in_lending_callback(
+    MIDI_in_data * input_data,
+    MIDI_lending_callback callback,
+    void *user_data
+  ) {
+    if (check_MIDI_in_callback(input_data->using_callback, callback != NULL) != 0) return -1;
+    // Configure input data
+    input_data->user_lending_callback = callback;
+    input_data->user_data = user_data;
+    input_data->using_callback = true;
+    return 0;
+}
+
+/**
+ * Sets a callback receiving SysEx messages in chunks, as they arrive from Alsa.
+ * Chunks are passed straight from Alsa events, so a message is never assembled
+ * or held in memory as a whole. Other messages are still passed
+ * to a regular callback or a queue, so it can be combined with any other callback,
+ * but it is set once.
+ *
+ * :param input_data: :c:type:`MIDI_in_data` instance
+ * :param callback: :c:type:`MIDI_sysex_chunk_callback` instance
+ * :param user_data: an optional pointer to additional data that is passed
+ *                   to the callback function whenever it is called.
+ *
+ * :returns: **0** on success, **-1** when callback is **NULL** or a SysEx callback is already set
+ *
+ * :since: v0.2
+ */
+int set_MIDI_in_sysex_chunk_callback(
+    MIDI_in_data * input_data,
+    MIDI_sysex_chunk_callback callback,
+    void *user_data
+  ) {
+    if (check_MIDI_in_callback(input_data->user_sysex_chunk_callback != NULL, callback != NULL) != 0) return -1;
+    // Configure input data
+    input_data->user_sysex_chunk_callback = callback;
+    input_data->sysex_user_data = user_data;
+    input_data->streaming_sysex = false;
+    return 0;
+}
+
+/**
+ * Sets a handler of a single message type. Events of that type are passed to it
+ * with fields read straight from an Alsa event: no MIDI bytes are made, parsed or queued.
+ * Other types keep going to a callback or a queue, so clock messages can be handled
+ * in the input thread while notes are queued, for example.
+ * Alsa events making several messages, like 14-bit controllers and parameter numbers,
+ * always take a usual path; SysEx handlers get assembled messages.
+ * Call it before a port is opened, like other callbacks.
+ *
+ * :param input_data: :c:type:`MIDI_in_data` instance
+ * :param type: a message type, any :c:type:`mf_type_t` value except :c:member:`mf_type_t.MF_OTHER`
+ * :param callback: :c:type:`MIDI_typed_callback` instance, **NULL** removes a handler
+ * :param user_data: an optional pointer to additional data that is passed
+ *                   to the callback function whenever it is called.
+ *
+ * :returns: **0** on success, **-1** for an unsupported type
+ *
+ * :since: v0.2
+ */
+int set_MIDI_in_typed_callback(
+    MIDI_in_data * input_data,
+    mf_type_t type,
+    MIDI_typed_callback callback,
+    void * user_data
+  ) {
+    int result = 0;
+    do {
+        if ( type < 0 || type >= MF_OTHER ) {
+            slog("MIDI in", "message type can't have a typed callback.");
+            result = -1;
+            break;
+        }
+        input_data->typed_callbacks[type] = callback;
+        input_data->typed_user_data[type] = user_data;
+        input_data->using_typed_callbacks = false;
+        for (int type_idx = 0; type_idx < MF_TYPE_COUNT; type_idx++)
+            if (input_data->typed_callbacks[type_idx]) input_data->using_typed_callbacks = true;
+    } while (0);
+    return result;
+}
+
+/**
+ * Returns a sequencer client and port of a message being passed to a callback.
+ * Valid only during a callback call, queued messages carry their own
+ * :c:member:`MIDI_message.source` or :c:member:`MIDI_event.source`.
+ * Callbacks run by :c:member:`RMR_Port_config.callback_workers` read
+ * :c:member:`MIDI_event.source` instead, this value belongs to the input thread.
+ *
+ * :param input_data: :c:type:`MIDI_in_data` instance
+ *
+ * :returns: a sender address
+ *
+ * :since: v0.2
+ */
+snd_seq_addr_t get_midi_input_source(MIDI_in_data * input_data) {
+    return input_data->source;
+}
+
+/**
+ * Replaces messages accepted by the input thread.
+ * A filter is read by the input thread without locks, so call it
+ * before a port is opened, or between :c:func:`process_midi_input` calls for threadless ports.
+ *
+ * :param input_data: :c:type:`MIDI_in_data` instance
+ * :param config: a :c:type:`MIDI_filter_config` instance
+ *
+ * :since: v0.2
+ */
+void set_midi_input_filter(MIDI_in_data * input_data, const MIDI_filter_config * config) {
+    compile_midi_filter(&input_data->filter, config);
+}
+
+/**
+ * Copies a current state of a channel tracked by the input thread, without locks,
+ * so it can be called from an audio thread instead of reading a queue.
+ * Works when :c:member:`RMR_Port_config.track_channel_state` is set.
+ *
+ * :param input_data: :c:type:`MIDI_in_data` instance
+ * :param channel: a channel from 0 to 15
+ * :param state: a :c:type:`MIDI_channel_state` instance to fill
+ *
+ * :returns: **true** when a state was copied, **false** when states are not tracked
+ *
+ * :since: v0.2
+ */
+bool get_midi_channel_state(MIDI_in_data * input_data, unsigned char channel, MIDI_channel_state * state) {
+    if (input_data->channel_state == NULL) return false;
+    read_channel_state(input_data->channel_state, channel, state);
+    return true;
+}
+
+/**
+ * Adds a consumer receiving every input message in its own ring,
+ * works when :c:member:`RMR_Port_config.fan_out` is set.
+ * Can be called while a port is running, a consumer gets messages received after this call.
+ * Read it with :c:func:`pop_consumer_event` or :c:func:`pop_consumer_events`
+ * from a single thread.
+ *
+ * :param input_data: :c:type:`MIDI_in_data` instance
+ * :param ring_size: an amount of ring slots, **0** uses :c:data:`CONSUMER_RING_SIZE`
+ * :param overflow_policy: what the input thread does when this consumer's ring is full,
+ *                         other consumers are not affected unless it waits
+ * :param consumer: a double pointer set to a :c:type:`MIDI_consumer` instance,
+ *                  owned by input_data
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int add_midi_consumer(
+    MIDI_in_data * input_data,
+    size_t ring_size,
+    overflow_policy_t overflow_policy,
+    MIDI_consumer ** consumer
+  ) {
+    int result = 0;
+    * consumer = NULL;
+    do {
+        if (input_data->fan_out == NULL) {
+            slog("Fan-out", "A port was prepared without fan_out.");
+            result = -1;
+            break;
+        }
+        if (add_fan_out_consumer(
+            input_data->fan_out, ring_size > 0 ? ring_size : CONSUMER_RING_SIZE, overflow_policy, consumer
+        ) != 0) {
+            slog("Fan-out", "Unable to add a consumer.");
+            result = -1;
+            break;
+        }
+    } while (0);
+    return result;
+}
+
+/**
+ * Fills a :c:type:`MIDI_event` instance from a message buffer.
+ * SysEx messages are marked with :c:data:`MIDI_EVENT_SYSEX`, other messages longer than
+ * :c:data:`MIDI_EVENT_INLINE_SIZE` with :c:data:`MIDI_EVENT_LONG`, their bytes are not copied.
+ *
+ * :param event: a :c:type:`MIDI_event` instance to fill
+ * :param buf: message bytes
+ * :param count: length of buf
+ * :param time_ns: absolute time of a message in nanoseconds,
+ *                or a queue tick with :c:member:`ts_mode_t.TS_TICK`
+ *
+ * :since: v0.2
+ */
+void fill_midi_event(MIDI_event * event, const unsigned char * buf, long count, uint64_t time_ns) {
+    event->time_ns = time_ns;
+    event->flags = 0;
+    if (count > MIDI_EVENT_INLINE_SIZE || (count > 0 && buf[0] == 0xF0)) {
+        event->sysex_count = (uint32_t) count;
+        event->count = 0;
+        event->flags |= buf[0] == 0xF0 ? MIDI_EVENT_SYSEX : MIDI_EVENT_LONG;
+    } else {
+        memset(event->bytes, 0, MIDI_EVENT_INLINE_SIZE);
+        memcpy(event->bytes, buf, count);
+        event->count = (unsigned char) count;
+    }
+}
+
+/**
+ * Signals :c:member:`MIDI_in_data.wakeup_fd` unless it is already signalled.
+ * Many publications between two :c:func:`clear_midi_input_wakeup` calls
+ * cause a single wakeup.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :since: v0.2
+ */
+void signal_midi_input(MIDI_in_data * input_data) {
+    if (input_data->wakeup_fd < 0) return;
+    if (atomic_exchange(&input_data->wakeup_pending, true)) return;
+    uint64_t one = 1;
+    int res = write(input_data->wakeup_fd, &one, sizeof(one));
+    (void) res;
+}
+
+/**
+ * Add an :c:type:`error_message` instance to :c:type:`MIDI_in_data` instance
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance containing a queue to send an error to
+ * :param etype: error type string, for example, "V0001", "S0001"
+ * :param msg: error message
+ *
+ * :since: v0.1
+ */
+void enqueue_error(MIDI_in_data * input_data, char * etype, char * msg) {
+    error_message *err = g_new(error_message, 1);
+    strncpy(err->error_type, etype, ERROR_MSG_ETYPE_SIZE);
+    strncpy(err->message, msg, ERROR_MSG_TEXT_SIZE);
+    g_async_queue_push(input_data->error_async_queue, err);
+    signal_midi_input(input_data);
+}
+
+/**
+ * Publishes messages and events enqueued by the input thread to a consumer:
+ * pushes them to a GLib asynchronous queue under a single lock
+ * or updates ring buffer positions once.
+ * Called from the input thread only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :since: v0.2
+ */
+void flush_input_batch(MIDI_in_data * input_data) {
+    bool published = false;
+    // Consumers have descriptors of their own
+    if (input_data->fan_out) publish_fan_out(input_data->fan_out, !input_data->amidi_data->threadless);
+    // Workers are separate threads even in a threadless mode
+    if (input_data->callback_pool) publish_callback_jobs(input_data->callback_pool);
+    // SysEx payloads are published first, so an event never arrives without one.
+    // Only the producer writes a head, so a relaxed load is enough
+    if (
+        input_data->sysex_ring && input_data->sysex_ring->head_pending !=
+        atomic_load_explicit(&input_data->sysex_ring->head, memory_order_relaxed)
+    ) {
+        ring_buffer_publish(input_data->sysex_ring);
+        published = true;
+    }
+    if (
+        input_data->sysex_lane && input_data->sysex_lane->head_pending !=
+        atomic_load_explicit(&input_data->sysex_lane->head, memory_order_relaxed)
+    ) {
+        ring_buffer_publish(input_data->sysex_lane);
+        published = true;
+    }
+    if (input_data->queue_type == MQ_ASYNC_QUEUE && input_data->batch_count > 0) {
+        g_async_queue_lock(input_data->midi_async_queue);
+        for (unsigned int msg_idx = 0; msg_idx < input_data->batch_count; msg_idx++) {
+            g_async_queue_push_unlocked(input_data->midi_async_queue, input_data->batch[msg_idx]);
+        }
+        gint depth = g_async_queue_length_unlocked(input_data->midi_async_queue);
+        g_async_queue_unlock(input_data->midi_async_queue);
+        input_data->queue_length = depth > 0 ? depth : 0;
+        if (depth > 0) update_port_queue_depth(&input_data->amidi_data->stats, depth);
+        input_data->batch_count = 0;
+        published = true;
+    } else if (
+        input_data->queue_type != MQ_ASYNC_QUEUE && input_data->midi_ring->head_pending !=
+        atomic_load_explicit(&input_data->midi_ring->head, memory_order_relaxed)
+    ) {
+        ring_buffer_publish(input_data->midi_ring);
+        update_port_queue_depth(&input_data->amidi_data->stats, ring_buffer_count(input_data->midi_ring));
+        published = true;
+    }
+    if (!published) return;
+    // A consumer is woken up after messages become visible,
+    // in a threadless mode it is the current thread
+    if (!input_data->amidi_data->threadless) signal_midi_input(input_data);
+}
+
+/**
+ * Pass a :c:type:`MIDI_message` instance to a consumer using a queue type
+ * selected for :c:type:`MIDI_in_data` instance.
+ * A message becomes visible to a consumer after :c:func:`flush_input_batch` call.
+ * Called from the input thread only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance containing a queue to send a message to
+ * :param message: a message to send, ownership is passed to a consumer
+ *
+ * :returns: **0** on success, **-1** when a ring buffer is full and a message was dropped
+ *
+ * :since: v0.2
+ */
+int enqueue_midi_message(MIDI_in_data * input_data, MIDI_message * message) {
+    int result = 0;
+    if (input_data->queue_type == MQ_RING_BUFFER) {
+        if (!ring_buffer_push_deferred(input_data->midi_ring, &message)) {
+            release_midi_message(input_data, message);
+            result = -1;
+        }
+    } else {
+        input_data->batch[input_data->batch_count++] = message;
+        if (input_data->batch_count == MIDI_INPUT_BATCH_SIZE) flush_input_batch(input_data);
+    }
+    return result;
+}
+
+/**
+ * Pass a message to a consumer as a :c:type:`MIDI_event` value
+ * using :c:member:`mq_type_t.MQ_EVENT_RING` queue type.
+ * SysEx and long message payloads are copied to a :c:type:`MIDI_message` and passed
+ * through :c:member:`MIDI_in_data.sysex_ring` before an event itself.
+ * An event becomes visible to a consumer after :c:func:`flush_input_batch` call.
+ * Called from the input thread only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance containing a queue to send an event to
+ * :param buf: message bytes
+ * :param count: length of buf
+ * :param timestamp: time in seconds elapsed since the previous message
+ * :param time_ns: absolute time of a message in nanoseconds
+ * :param tick: a queue tick of a message with :c:member:`ts_mode_t.TS_TICK`
+ *
+ * :returns: **0** on success, **-1** when a ring buffer is full and an event was dropped
+ *
+ * :since: v0.2
+ */
+int enqueue_midi_event(
+    MIDI_in_data * input_data,
+    const unsigned char * buf,
+    long count,
+    double timestamp,
+    uint64_t time_ns,
+    unsigned int tick
+  ) {
+    int result = 0;
+    MIDI_event event;
+    // An event holds a tick in place of time, a payload has both like any message
+    fill_midi_event(&event, buf, count, input_data->amidi_data->timestamp_mode == TS_TICK ? tick : time_ns);
+    event.source = input_data->source;
+    do {
+        if (event.flags & MIDI_EVENT_PAYLOAD) {
+            // Check there's room for an event, so a payload is never left without one
+            if (ring_buffer_full(input_data->midi_ring)) {
+                result = -1;
+                break;
+            }
+            MIDI_message * sysex = new_midi_message(input_data, count);
+            memcpy(sysex->buf, buf, count);
+            sysex->timestamp = timestamp;
+            sysex->time_ns = time_ns;
+            sysex->tick = tick;
+            sysex->source = input_data->source;
+            if (!ring_buffer_push_deferred(input_data->sysex_ring, &sysex)) {
+                release_midi_message(input_data, sysex);
+                result = -1;
+                break;
+            }
+        }
+        if (!ring_buffer_push_deferred(input_data->midi_ring, &event)) result = -1;
+    } while (0);
+    return result;
+}
+
+/**
+ * Passes a realtime or a SysEx message to its own lane
+ * when :c:member:`RMR_Port_config.priority_lanes` is set.
+ * Realtime messages are published at once, without waiting for :c:func:`flush_input_batch`,
+ * SysEx messages are published with a batch. A full lane drops a new message,
+ * :c:member:`MIDI_in_data.overflow_policy` only applies to other messages.
+ * Called from the input thread only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance with priority lanes
+ * :param buf: message bytes
+ * :param count: length of buf
+ * :param timestamp: time in seconds elapsed since the previous message
+ * :param time_ns: absolute time of a message in nanoseconds
+ * :param tick: a queue tick of a message with :c:member:`ts_mode_t.TS_TICK`
+ *
+ * :returns: **0** on success, **-1** when a lane is full and a message was dropped
+ *
+ * :since: v0.2
+ */
+int enqueue_lane_message(
+    MIDI_in_data * input_data,
+    const unsigned char * buf,
+    long count,
+    double timestamp,
+    uint64_t time_ns,
+    unsigned int tick
+  ) {
+    int result = 0;
+    bool realtime = get_message_class(buf[0]) == MC_REALTIME;
+    MIDI_ring_buffer * lane = realtime ? input_data->realtime_ring : input_data->sysex_lane;
+    do {
+        // A single producer checks for room once, so a push below never fails
+        if (ring_buffer_full(lane)) {
+            result = -1;
+            break;
+        }
+        if (realtime && input_data->queue_type == MQ_EVENT_RING) {
+            MIDI_event event;
+            fill_midi_event(&event, buf, count, input_data->amidi_data->timestamp_mode == TS_TICK ? tick : time_ns);
+            event.source = input_data->source;
+            ring_buffer_push(lane, &event);
+        } else {
+            MIDI_message * message = new_midi_message(input_data, count);
+            memcpy(message->buf, buf, count);
+            message->timestamp = timestamp;
+            message->time_ns = time_ns;
+            message->tick = tick;
+            message->source = input_data->source;
+            if (realtime) ring_buffer_push(lane, &message);
+            else ring_buffer_push_deferred(lane, &message);
+        }
+        // Clock and transport messages don't wait for the rest of a batch
+        if (realtime && !input_data->amidi_data->threadless) signal_midi_input(input_data);
+    } while (0);
+    return result;
+}
+
+/**
+ * Checks if an input queue has no room for a new message. Called from the input thread only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ * :param sysex: a new message is a SysEx message, with :c:member:`mq_type_t.MQ_EVENT_RING`
+ *               it also needs a slot in :c:member:`MIDI_in_data.sysex_ring`
+ *
+ * :returns: **true** when a queue is full
+ *
+ * :since: v0.2
+ */
+bool input_queue_full(MIDI_in_data * input_data, bool sysex) {
+    if (input_data->queue_type == MQ_ASYNC_QUEUE)
+        return input_data->queue_capacity > 0 &&
+            input_data->queue_length + input_data->batch_count >= input_data->queue_capacity;
+    if (sysex && input_data->sysex_ring && ring_buffer_full(input_data->sysex_ring)) return true;
+    return ring_buffer_full(input_data->midi_ring);
+}
+
+/**
+ * Checks if a queued event can be discarded by :c:func:`drop_oldest_input`.
+ * A payload may already be paired with an event a consumer has read,
+ * so only events without a payload are discarded.
+ *
+ * :param item: a :c:type:`MIDI_event` instance
+ *
+ * :returns: **true** for inline events
+ *
+ * :since: v0.2
+ */
+bool is_discardable_event(const void * item) {
+    return !(((const MIDI_event *) item)->flags & MIDI_EVENT_PAYLOAD);
+}
+
+/**
+ * Removes the oldest message of an input queue for :c:member:`overflow_policy_t.OP_DROP_OLDEST`.
+ * A message carrying a pending coalesced value is moved to the end of a queue instead,
+ * so the latest value of its parameter still reaches a consumer.
+ * Messages have to be published with :c:func:`flush_input_batch` first.
+ * Called from the input thread only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :returns: **true** when a message was removed, **false** when nothing could be removed
+ *           or every queued message carries a value
+ *
+ * :since: v0.2
+ */
+bool drop_oldest_input(MIDI_in_data * input_data) {
+    MIDI_message * message = NULL;
+    MIDI_event event;
+    int slot;
+    // Every queued message is checked at most once
+    size_t attempts = input_data->queue_type == MQ_ASYNC_QUEUE ?
+        input_data->queue_length : input_data->midi_ring->capacity;
+    for (size_t attempt = 0; attempt < attempts; attempt++) {
+        if (input_data->queue_type == MQ_EVENT_RING) {
+            if (!ring_buffer_discard_oldest(input_data->midi_ring, &event, is_discardable_event)) return false;
+            slot = get_coalesce_slot(event.bytes, event.count);
+        } else {
+            if (input_data->queue_type == MQ_RING_BUFFER) {
+                if (!ring_buffer_discard_oldest(input_data->midi_ring, &message, NULL)) return false;
+            } else {
+                message = g_async_queue_try_pop(input_data->midi_async_queue);
+                if (message == NULL) return false;
+            }
+            slot = get_coalesce_slot(message->buf, message->count);
+        }
+        // A removed message just made room, so pushing it back never fails
+        if (input_data->coalesce && slot >= 0 && is_coalesced_value_pending(input_data->coalesce, slot)) {
+            if (input_data->queue_type == MQ_EVENT_RING) ring_buffer_push(input_data->midi_ring, &event);
+            else if (input_data->queue_type == MQ_RING_BUFFER) ring_buffer_push(input_data->midi_ring, &message);
+            else g_async_queue_push(input_data->midi_async_queue, message);
+            continue;
+        }
+        if (input_data->queue_type != MQ_EVENT_RING) release_midi_message(input_data, message);
+        if (input_data->queue_type == MQ_ASYNC_QUEUE && input_data->queue_length > 0) input_data->queue_length--;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Applies :c:member:`MIDI_in_data.overflow_policy` when an input queue is full.
+ * Drops and replaced parked values are counted in :c:member:`MIDI_port_stats.queue_drops`.
+ * Called from the input thread only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ * :param buf: bytes of a new message
+ * :param count: length of buf
+ * :param event_time: absolute time of a new message in nanoseconds,
+ *                    or a queue tick with :c:member:`ts_mode_t.TS_TICK`
+ *
+ * :returns: **true** when a new message can be queued, **false** when it was dropped or parked
+ *
+ * :since: v0.2
+ */
+bool make_input_queue_room(MIDI_in_data * input_data, const unsigned char * buf, long count, uint64_t event_time) {
+    bool sysex = count > MIDI_EVENT_INLINE_SIZE || buf[0] == 0xF0;
+    if (!input_queue_full(input_data, sysex)) return true;
+    // Staged messages are published first, a consumer may have made room meanwhile
+    flush_input_batch(input_data);
+    if (input_data->queue_type == MQ_ASYNC_QUEUE)
+        input_data->queue_length = g_async_queue_length(input_data->midi_async_queue);
+    if (!input_queue_full(input_data, sysex)) return true;
+    MIDI_port_stats * stats = &input_data->amidi_data->stats;
+    switch (input_data->overflow_policy) {
+    case OP_DROP_OLDEST:
+        if (drop_oldest_input(input_data)) {
+            port_stats_add(&stats->queue_drops, 1);
+            if (!input_queue_full(input_data, sysex)) return true;
+        }
+        break;
+    case OP_BLOCK:
+        // In a threadless mode a consumer runs in this thread and can't make room
+        while (
+            !input_data->amidi_data->threadless && input_data->do_input &&
+            input_queue_full(input_data, sysex)
+        ) {
+            // A consumer signals after reads, a queue is checked again after a flag is set
+            prepare_room_wait(&input_data->room);
+            if (input_data->queue_type == MQ_ASYNC_QUEUE)
+                input_data->queue_length = g_async_queue_length(input_data->midi_async_queue);
+            wait_for_room(&input_data->room, input_queue_full(input_data, sysex));
+        }
+        if (!input_queue_full(input_data, sysex)) return true;
+        break;
+    case OP_COALESCE: {
+        int slot = get_coalesce_slot(buf, count);
+        // Only inline events are parked, a long message would lose its bytes and is dropped
+        if (slot < 0 || count > MIDI_EVENT_INLINE_SIZE) break;
+        MIDI_event event;
+        fill_midi_event(&event, buf, count, event_time);
+        event.source = input_data->source;
+        // Only a replaced older value is lost
+        if (park_event(input_data->parked, slot, &event)) port_stats_add(&stats->queue_drops, 1);
+        return false;
+    }
+    default:
+        break;
+    }
+    port_stats_add(&stats->queue_drops, 1);
+    return false;
+}
+
+/**
+ * Passes a complete message to an input queue selected by :c:member:`MIDI_in_data.queue_type`,
+ * applies an overflow policy when a queue is full.
+ * Called from the input thread only.
+ *
+ * :param in_data: a :c:type:`MIDI_in_data` instance
+ * :param data: message bytes, copied to a queue
+ * :param count: length of data
+ * :param timestamp: time in seconds elapsed since the previous message
+ * :param time_ns: absolute time of a message in nanoseconds
+ * :param tick: a queue tick of a message with :c:member:`ts_mode_t.TS_TICK`
+ *
+ * :since: v0.2
+ */
+void queue_input_message(
+    MIDI_in_data * in_data,
+    const unsigned char * data,
+    long count,
+    double timestamp,
+    uint64_t time_ns,
+    unsigned int tick
+  ) {
+    int result;
+    uint64_t event_time = in_data->amidi_data->timestamp_mode == TS_TICK ? tick : time_ns;
+    int slot = in_data->coalesce ? get_coalesce_slot(data, count) : -1;
+    // A queued message of the same parameter will carry this value to a consumer
+    if (slot >= 0 && store_coalesced_value(in_data->coalesce, slot, data, count, event_time, in_data->source)) {
+        port_stats_add(&in_data->amidi_data->stats.coalesced, 1);
+        return;
+    }
+    mc_type_t msg_class = get_message_class(data[0]);
+    if (in_data->realtime_ring && (msg_class == MC_REALTIME || msg_class == MC_SYSEX)) {
+        result = enqueue_lane_message(in_data, data, count, timestamp, time_ns, tick);
+    } else if (!make_input_queue_room(in_data, data, count, event_time)) {
+        // A parked message is queued later, a dropped one can't carry a value
+        if (slot >= 0 && in_data->overflow_policy != OP_COALESCE)
+            clear_coalesced_value(in_data->coalesce, slot);
+        return;
+    } else if (in_data->queue_type == MQ_EVENT_RING) {
+        // Short messages are copied by value, SysEx payloads are passed separately
+        result = enqueue_midi_event(in_data, data, count, timestamp, time_ns, tick);
+    } else {
+        // Taken from a message pool when it is available
+        MIDI_message * message = new_midi_message(in_data, count);
+        memcpy(message->buf, data, count);
+        message->timestamp = timestamp;
+        message->time_ns = time_ns;
+        message->tick = tick;
+        message->source = in_data->source;
+        result = enqueue_midi_message(in_data, message);
+    }
+    if (result != 0) {
+        if (slot >= 0) clear_coalesced_value(in_data->coalesce, slot);
+        // Drops are only counted, logging every one would stall the input thread under overload
+        port_stats_add(&in_data->amidi_data->stats.queue_drops, 1);
+    }
+}
+
+/**
+ * Applies an overflow policy of a consumer when its ring is full.
+ * Messages dropped to make room are counted in :c:member:`MIDI_consumer.drops`.
+ * Called from the input thread only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ * :param consumer: a :c:type:`MIDI_consumer` instance
+ *
+ * :returns: **true** when a new message can be pushed
+ *
+ * :since: v0.2
+ */
+bool make_consumer_room(MIDI_in_data * input_data, MIDI_consumer * consumer) {
+    MIDI_fan_out_event dropped;
+    if (!ring_buffer_full(consumer->ring)) return true;
+    // Pushed events are published first, a consumer may have made room meanwhile
+    publish_fan_out(input_data->fan_out, !input_data->amidi_data->threadless);
+    if (!ring_buffer_full(consumer->ring)) return true;
+    switch (consumer->overflow_policy) {
+    case OP_DROP_OLDEST:
+        if (ring_buffer_discard_oldest(consumer->ring, &dropped, NULL)) {
+            // Other consumers may still hold the same payload
+            release_shared_payload(dropped.sysex);
+            port_stats_add(&consumer->drops, 1);
+        }
+        break;
+    case OP_BLOCK:
+        // A slow consumer stalls all others, like a single blocking queue does
+        while (
+            !input_data->amidi_data->threadless && input_data->do_input &&
+            !atomic_load(&consumer->closed) && ring_buffer_full(consumer->ring)
+        ) {
+            prepare_room_wait(&consumer->room);
+            wait_for_room(&consumer->room, !atomic_load(&consumer->closed) && ring_buffer_full(consumer->ring));
+        }
+        break;
+    default:
+        break;
+    }
+    return !ring_buffer_full(consumer->ring);
+}
+
+/**
+ * Passes a complete message to every open consumer with :c:member:`RMR_Port_config.fan_out`.
+ * Short messages are copied by value, a SysEx payload is copied once and shared by consumers.
+ * Messages become visible to consumers after :c:func:`flush_input_batch` call.
+ * Called from the input thread only.
+ *
+ * :param in_data: a :c:type:`MIDI_in_data` instance
+ * :param data: message bytes
+ * :param count: length of data
+ * :param event_time: absolute time of a message in nanoseconds,
+ *                    or a queue tick with :c:member:`ts_mode_t.TS_TICK`
+ *
+ * :since: v0.2
+ */
+void fan_out_input_message(MIDI_in_data * in_data, const unsigned char * data, long count, uint64_t event_time) {
+    MIDI_fan_out * fan_out = in_data->fan_out;
+    unsigned int consumer_count = atomic_load_explicit(&fan_out->count, memory_order_acquire);
+    MIDI_fan_out_event item;
+    if (consumer_count == 0) return;
+    fill_midi_event(&item.event, data, count, event_time);
+    item.event.source = in_data->source;
+    item.sysex = NULL;
+    if (item.event.flags & MIDI_EVENT_PAYLOAD) {
+        // The input thread holds a reference until every consumer has one
+        item.sysex = new_shared_payload(data, count);
+        if (item.sysex == NULL) {
+            slog("Alsa MIDI handler", "Unable to allocate memory for a SysEx payload.");
+            return;
+        }
+    }
+    for (unsigned int consumer_idx = 0; consumer_idx < consumer_count; consumer_idx++) {
+        MIDI_consumer * consumer = &fan_out->consumers[consumer_idx];
+        if (atomic_load_explicit(&consumer->closed, memory_order_relaxed)) continue;
+        if (!make_consumer_room(in_data, consumer)) {
+            port_stats_add(&consumer->drops, 1);
+            continue;
+        }
+        if (item.sysex) retain_shared_payload(item.sysex);
+        ring_buffer_push_deferred(consumer->ring, &item);
+    }
+    release_shared_payload(item.sysex);
+}
+
+/**
+ * Runs a callback handed off to a worker, called by :c:type:`MIDI_callback_pool` workers.
+ * Callbacks get the same arguments they get in the input thread,
+ * lent bytes are valid during a call.
+ *
+ * :param job: a :c:type:`MIDI_callback_job` instance
+ * :param context: a :c:type:`MIDI_in_data` instance
+ *
+ * :since: v0.2
+ */
+void run_callback_job(const MIDI_callback_job * job, void * context) {
+    MIDI_in_data * in_data = context;
+    MIDI_port_stats * stats = &in_data->amidi_data->stats;
+    const unsigned char * data = job->sysex ? job->sysex : job->event.bytes;
+    long count = job->sysex ? (long) job->event.sysex_count : job->event.count;
+    // Workers are timed like the input thread, so stats cover every call
+    uint64_t callback_start = in_data->amidi_data->time_callbacks ? get_monotonic_time_ns() : 0;
+    if (in_data->user_lending_callback) {
+        in_data->user_lending_callback(job->timestamp, job->event.time_ns, data, count, in_data->user_data);
+    } else if (in_data->user_event_callback) {
+        in_data->user_event_callback(job->event, job->sysex, in_data->user_data);
+    } else if (in_data->using_callback) {
+        // A callback owns a buffer copy
+        unsigned char * buf = calloc(count, sizeof(unsigned char));
+        if (buf == NULL) {
+            enqueue_error(in_data, "S0004", "Unable to allocate a callback message");
+            return;
+        }
+        memcpy(buf, data, count);
+        MIDI_callback callback = (MIDI_callback) in_data->user_callback;
+        callback(job->timestamp, buf, count, in_data->user_data);
+    }
+    if (callback_start) {
+        port_stats_add_shared(&stats->callback_calls, 1);
+        port_stats_add_shared(&stats->callback_ns, get_monotonic_time_ns() - callback_start);
+    }
+}
+
+/**
+ * Hands a callback call off to a worker of :c:member:`MIDI_in_data.callback_pool`.
+ * Messages of a single sender port and channel go to the same worker in arrival order.
+ * A full worker queue drops a message, with :c:member:`overflow_policy_t.OP_BLOCK`
+ * the input thread sleeps until a worker signals room instead.
+ * SysEx bytes are copied to a preallocated buffer of a worker, or to heap memory
+ * when buffers are busy or a message is longer than :c:data:`CALLBACK_SYSEX_BUFFER_SIZE`.
+ * Called from the input thread only.
+ *
+ * :param in_data: a :c:type:`MIDI_in_data` instance
+ * :param data: message bytes, copied for a worker
+ * :param count: length of data
+ * :param timestamp: time in seconds elapsed since the previous message
+ * :param event_time: absolute time of a message in nanoseconds,
+ *                    or a queue tick with :c:member:`ts_mode_t.TS_TICK`
+ *
+ * :since: v0.2
+ */
+void hand_off_callback(
+    MIDI_in_data * in_data,
+    const unsigned char * data,
+    long count,
+    double timestamp,
+    uint64_t event_time
+  ) {
+    MIDI_callback_pool * pool = in_data->callback_pool;
+    MIDI_callback_worker * worker = get_callback_worker(pool, in_data->source, data[0]);
+    MIDI_callback_job job;
+    if (ring_buffer_full(worker->jobs)) {
+        // Pending jobs are published first, a worker may have made room meanwhile
+        publish_callback_jobs(pool);
+        while (in_data->overflow_policy == OP_BLOCK && in_data->do_input && ring_buffer_full(worker->jobs)) {
+            prepare_room_wait(&pool->room);
+            wait_for_room(&pool->room, ring_buffer_full(worker->jobs));
+        }
+        if (ring_buffer_full(worker->jobs)) {
+            port_stats_add(&in_data->amidi_data->stats.queue_drops, 1);
+            return;
+        }
+    }
+    fill_midi_event(&job.event, data, count, event_time);
+    job.event.source = in_data->source;
+    job.timestamp = timestamp;
+    job.sysex = NULL;
+    job.pooled_sysex = false;
+    if (job.event.flags & MIDI_EVENT_PAYLOAD) {
+        if (take_job_sysex(worker, &job, count) != 0) {
+            port_stats_add(&in_data->amidi_data->stats.queue_drops, 1);
+            enqueue_error(in_data, "S0004", "Unable to allocate a callback message");
+            return;
+        }
+        memcpy(job.sysex, data, count);
+    }
+    ring_buffer_push_deferred(worker->jobs, &job);
+}
+
+/**
+ * Queues events parked by :c:member:`overflow_policy_t.OP_COALESCE` while there is room,
+ * in the order their parameters were parked. Called from the input thread only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :since: v0.2
+ */
+void offer_parked_events(MIDI_in_data * input_data) {
+    MIDI_parked_events * parked = input_data->parked;
+    unsigned int offered = 0;
+    if (parked == NULL || parked->count == 0) return;
+    if (input_data->queue_type == MQ_ASYNC_QUEUE)
+        input_data->queue_length = g_async_queue_length(input_data->midi_async_queue);
+    bool ticks = input_data->amidi_data->timestamp_mode == TS_TICK;
+    while (offered < parked->count && !input_queue_full(input_data, false)) {
+        int slot = parked->order[offered++];
+        MIDI_event * event = &parked->events[slot];
+        parked->used[slot] = false;
+        // Values coalesced after parking are newer, a slot is stored again by queue_input_message
+        if (input_data->coalesce)
+            take_coalesced_value(input_data->coalesce, slot, event->bytes, event->count, &event->time_ns, &event->source);
+        input_data->source = event->source;
+        // A delta to a previous message is unknown after parking
+        queue_input_message(
+            input_data, event->bytes, event->count, 0.0,
+            ticks ? 0 : event->time_ns, ticks ? (unsigned int) event->tick : 0
+        );
+    }
+    memmove(parked->order, parked->order + offered, (parked->count - offered) * sizeof(uint16_t));
+    parked->count -= offered;
+}
+
+/**
+ * Converts a popped :c:type:`MIDI_message` to a :c:type:`MIDI_event` value.
+ * Frees short messages, keeps SysEx and long message payloads for :c:func:`pop_midi_sysex`.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance a message was read from
+ * :param message: a :c:type:`MIDI_message` instance to convert
+ * :param event: a :c:type:`MIDI_event` instance to fill
+ *
+ * :returns: **true** when a message was a SysEx or a long message and its payload was kept
+ *
+ * :since: v0.2
+ */
+bool convert_midi_message(MIDI_in_data * input_data, MIDI_message * message, MIDI_event * event) {
+    fill_midi_event(
+        event,
+        message->buf,
+        message->count,
+        input_data->amidi_data->timestamp_mode == TS_TICK ? message->tick : message->time_ns
+    );
+    event->source = message->source;
+    if (event->flags & MIDI_EVENT_PAYLOAD) {
+        if (input_data->pending_sysex) free_midi_message(input_data->pending_sysex);
+        input_data->pending_sysex = message;
+        return true;
+    }
+    free_midi_message(message);
+    return false;
+}
+
+/**
+ * Records latencies of events read by a consumer, from their Alsa event time to now.
+ * Does nothing unless :c:member:`RMR_Port_config.measure_latency` is set.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance events were read from
+ * :param events: read events
+ * :param count: an amount of events
+ *
+ * :since: v0.2
+ */
+void record_dequeue_latency(MIDI_in_data * input_data, const MIDI_event * events, size_t count) {
+    MIDI_latency_histogram * histogram = input_data->amidi_data->dequeue_latency;
+    if (histogram == NULL || count == 0) return;
+    // A batch is handed over at once, a single clock read is enough
+    uint64_t now = get_monotonic_time_ns();
+    for (size_t event_idx = 0; event_idx < count; event_idx++) {
+        uint64_t time_ns = events[event_idx].time_ns;
+        record_latency(histogram, now > time_ns ? now - time_ns : 0);
+    }
+}
+
+/**
+ * Replaces bytes of a read message by the latest value of its parameter
+ * when :c:member:`RMR_Port_config.coalesce_controllers` is set, look at :c:type:`MIDI_coalesce_table`.
+ * Called from a consumer.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance a message was read from
+ * :param message: a read :c:type:`MIDI_message` instance
+ *
+ * :since: v0.2
+ */
+void resolve_coalesced_message(MIDI_in_data * input_data, MIDI_message * message) {
+    uint64_t time;
+    if (input_data->coalesce == NULL) return;
+    int slot = get_coalesce_slot(message->buf, message->count);
+    if (slot < 0 || !take_coalesced_value(input_data->coalesce, slot, message->buf, message->count, &time, &message->source))
+        return;
+    if (input_data->amidi_data->timestamp_mode == TS_TICK) message->tick = (unsigned int) time;
+    else message->time_ns = time;
+}
+
+/**
+ * Replaces bytes of read events by the latest values of their parameters
+ * when :c:member:`RMR_Port_config.coalesce_controllers` is set, look at :c:type:`MIDI_coalesce_table`.
+ * Called from a consumer.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance events were read from
+ * :param events: read events
+ * :param count: an amount of events
+ *
+ * :since: v0.2
+ */
+void resolve_coalesced_events(MIDI_in_data * input_data, MIDI_event * events, size_t count) {
+    if (input_data->coalesce == NULL) return;
+    for (size_t event_idx = 0; event_idx < count; event_idx++) {
+        MIDI_event * event = &events[event_idx];
+        if (event->flags & MIDI_EVENT_PAYLOAD) continue;
+        int slot = get_coalesce_slot(event->bytes, event->count);
+        if (slot >= 0)
+            take_coalesced_value(input_data->coalesce, slot, event->bytes, event->count, &event->time_ns, &event->source);
+    }
+}
+
+/**
+ * Retrieve the next :c:type:`MIDI_message` instance without blocking,
+ * works for :c:member:`mq_type_t.MQ_ASYNC_QUEUE` and :c:member:`mq_type_t.MQ_RING_BUFFER` queue types.
+ * A caller owns a message and frees it with :c:func:`free_midi_message`.
+ * :c:member:`mq_type_t.MQ_EVENT_RING` ports, lanes included, are read with :c:func:`pop_midi_event`
+ * or :c:func:`pop_midi_event_batch`, this function returns **NULL** for them.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance to read a message from
+ *
+ * :returns: a :c:type:`MIDI_message` pointer or **NULL** when no messages are pending
+ *
+ * :since: v0.2
+ */
+MIDI_message * pop_midi_message(MIDI_in_data * input_data) {
+    MIDI_message * message = NULL;
+    // An event ring and its realtime lane hold MIDI_event values, not message pointers
+    if (input_data->queue_type == MQ_EVENT_RING) return NULL;
+    // With priority lanes realtime messages go first and SysEx messages go last
+    if (input_data->realtime_ring && !ring_buffer_pop(input_data->realtime_ring, &message)) message = NULL;
+    if (message == NULL && input_data->queue_type == MQ_RING_BUFFER) {
+        if (!ring_buffer_pop(input_data->midi_ring, &message)) message = NULL;
+    } else if (message == NULL && input_data->queue_type == MQ_ASYNC_QUEUE) {
+        message = g_async_queue_try_pop(input_data->midi_async_queue);
+    }
+    if (message == NULL && input_data->sysex_lane && !ring_buffer_pop(input_data->sysex_lane, &message))
+        message = NULL;
+    if (message == NULL) return NULL;
+    signal_room(&input_data->room);
+    resolve_coalesced_message(input_data, message);
+    if (input_data->amidi_data->dequeue_latency != NULL) {
+        uint64_t now = get_monotonic_time_ns();
+        record_latency(input_data->amidi_data->dequeue_latency, now > message->time_ns ? now - message->time_ns : 0);
+    }
+    return message;
+}
+
+/**
+ * Retrieve the next message as a :c:type:`MIDI_event` value without blocking,
+ * works for all queue types.
+ * When a :c:data:`MIDI_EVENT_PAYLOAD` flag is set, a payload is retrieved
+ * with :c:func:`pop_midi_sysex` before the next event is read.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance to read an event from
+ * :param event: a :c:type:`MIDI_event` instance to fill
+ *
+ * :returns: **true** when an event was read, **false** when no events are pending
+ *
+ * :since: v0.2
+ */
+bool pop_midi_event(MIDI_in_data * input_data, MIDI_event * event) {
+    MIDI_message * message;
+    if (input_data->queue_type == MQ_EVENT_RING) {
+        if (
+            !(input_data->realtime_ring && ring_buffer_pop(input_data->realtime_ring, event)) &&
+            !ring_buffer_pop(input_data->midi_ring, event)
+        ) {
+            // A SysEx lane holds messages only, an event is made of a message
+            if (!input_data->sysex_lane || !ring_buffer_pop(input_data->sysex_lane, &message)) return false;
+            convert_midi_message(input_data, message, event);
+        } else if ((event->flags & MIDI_EVENT_PAYLOAD) && input_data->pending_sysex) {
+            // A lane payload nobody read would be returned instead of a payload of this event
+            free_midi_message(input_data->pending_sysex);
+            input_data->pending_sysex = NULL;
+        }
+        signal_room(&input_data->room);
+        resolve_coalesced_events(input_data, event, 1);
+        record_dequeue_latency(input_data, event, 1);
+        return true;
+    }
+    message = pop_midi_message(input_data);
+    if (message == NULL) return false;
+    convert_midi_message(input_data, message, event);
+    return true;
+}
+
+/**
+ * Returns a file descriptor that becomes readable when messages or errors
+ * are published, it can be added to poll, select or epoll sets.
+ * Signals are edge-like: a burst of messages makes a descriptor readable once,
+ * so after a wakeup call :c:func:`clear_midi_input_wakeup` first
+ * and then read until queues are empty.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :returns: an eventfd descriptor or **-1** when it is unavailable
+ *
+ * :since: v0.2
+ */
+int get_midi_input_fd(MIDI_in_data * input_data) {
+    return input_data->wakeup_fd;
+}
+
+/**
+ * Clears a signalled :c:member:`MIDI_in_data.wakeup_fd`.
+ * Messages published after this call signal it again.
+ * Called from a consumer thread before reading queues.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :since: v0.2
+ */
+void clear_midi_input_wakeup(MIDI_in_data * input_data) {
+    uint64_t value;
+    if (input_data->wakeup_fd < 0) return;
+    // Read a counter first, so a signal sent in between is never lost
+    int res = read(input_data->wakeup_fd, &value, sizeof(value));
+    (void) res;
+    atomic_store(&input_data->wakeup_pending, false);
+}
+
+/**
+ * Checks if a MIDI message queue has messages to read.
  *
- * :param amidi_data: a double pointer used to allocate memory for a :c:type:`Alsa_MIDI_data` instance
+ * :param input_data: a :c:type:`MIDI_in_data` instance
  *
- * :since: v0.1
+ * :returns: **true** when a queue is not empty
+ *
+ * :since: v0.2
  */
-void init_amidi_data_instance(Alsa_MIDI_data ** amidi_data) {
-    * amidi_data = NULL;
-    * amidi_data = malloc(sizeof(Alsa_MIDI_data));
-    if (amidi_data == NULL) slog("Start", "Unable to allocate memory for Alsa_MIDI_data instance.");
+bool has_midi_input(MIDI_in_data * input_data) {
+    if (
+        input_data->realtime_ring &&
+        (ring_buffer_count(input_data->realtime_ring) > 0 || ring_buffer_count(input_data->sysex_lane) > 0)
+    ) return true;
+    if (input_data->queue_type == MQ_ASYNC_QUEUE)
+        return g_async_queue_length(input_data->midi_async_queue) > 0;
+    return ring_buffer_count(input_data->midi_ring) > 0;
 }
 
 /**
- * Creates an assigns a MIDI message queue for a :c:type:`MIDI_in_data` instance
+ * Waits until a MIDI message queue has messages to read or a timeout expires.
+ * Uses :c:member:`MIDI_in_data.wakeup_fd` and falls back to periodic checks
+ * when it is unavailable.
  *
- * :param input_data: a pointer containing a :c:type:`MIDI_in_data` instance for creating a :c:type:`GAsyncQueue` instance.
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ * :param timeout: a time to wait in microseconds, a negative value waits without a limit
  *
- * :since: v0.1
+ * :returns: **true** when a queue is not empty
+ *
+ * :since: v0.2
  */
-void assign_midi_queue(MIDI_in_data * input_data) {
-    input_data->midi_async_queue = g_async_queue_new();
-    g_async_queue_ref(input_data->midi_async_queue);
+bool wait_for_midi_input(MIDI_in_data * input_data, long timeout) {
+    clear_midi_input_wakeup(input_data);
+    if (has_midi_input(input_data)) return true;
+    if (input_data->wakeup_fd < 0) {
+        g_usleep(timeout >= 0 && timeout < RING_BUFFER_WAIT_INTERVAL ? timeout : RING_BUFFER_WAIT_INTERVAL);
+    } else {
+        struct pollfd poll_fd = { .fd = input_data->wakeup_fd, .events = POLLIN };
+        // Round up, so a short timeout doesn't turn into a busy loop
+        int res = poll(&poll_fd, 1, timeout < 0 ? -1 : (int)((timeout + 999) / 1000));
+        (void) res;
+    }
+    return has_midi_input(input_data);
 }
 
 /**
- * Assign :c:type:`Alsa_MIDI_data` instance to :c:type:`MIDI_in_data` instance
+ * Reads pending events of a port with :c:member:`RMR_Port_config.priority_lanes` without blocking:
+ * realtime events first, then other messages, then at most one SysEx event,
+ * its payload is kept for :c:func:`pop_midi_sysex`. With :c:member:`mq_type_t.MQ_EVENT_RING`
+ * a SysEx event is only added when other events of a batch have no payloads.
  *
- * :param input_data: :c:type:`MIDI_in_data` instance
- * :param amidi_data: :c:type:`Alsa_MIDI_data` instance
+ * :param input_data: a :c:type:`MIDI_in_data` instance with priority lanes
+ * :param events: an array of at least **max** :c:type:`MIDI_event` instances to fill
+ * :param max: a maximal amount of events to read
  *
- * :since: v0.1
+ * :returns: an amount of events read
+ *
+ * :since: v0.2
  */
-void assign_midi_data(MIDI_in_data * input_data, Alsa_MIDI_data * amidi_data) {
-    input_data->amidi_data = amidi_data;
+size_t pop_lane_events(MIDI_in_data * input_data, MIDI_event * events, size_t max) {
+    size_t count = 0;
+    size_t popped;
+    bool payloads = false;
+    MIDI_message * message;
+    if (input_data->queue_type == MQ_EVENT_RING) {
+        count = ring_buffer_pop_batch(input_data->realtime_ring, events, max);
+        if (count < max) {
+            popped = ring_buffer_pop_batch(input_data->midi_ring, events + count, max - count);
+            resolve_coalesced_events(input_data, events + count, popped);
+            for (size_t event_idx = count; event_idx < count + popped; event_idx++)
+                if (events[event_idx].flags & MIDI_EVENT_PAYLOAD) payloads = true;
+            count += popped;
+        }
+        // Payloads of long messages are read from a ring, a lane payload would be read in their place
+        if (payloads && input_data->pending_sysex) {
+            free_midi_message(input_data->pending_sysex);
+            input_data->pending_sysex = NULL;
+        }
+    } else {
+        while (count < max && ring_buffer_pop(input_data->realtime_ring, &message))
+            convert_midi_message(input_data, message, &events[count++]);
+        if (input_data->queue_type == MQ_ASYNC_QUEUE) g_async_queue_lock(input_data->midi_async_queue);
+        while (count < max) {
+            if (input_data->queue_type == MQ_ASYNC_QUEUE) {
+                message = g_async_queue_try_pop_unlocked(input_data->midi_async_queue);
+                if (message == NULL) break;
+            } else if (!ring_buffer_pop(input_data->midi_ring, &message)) {
+                break;
+            }
+            resolve_coalesced_message(input_data, message);
+            convert_midi_message(input_data, message, &events[count++]);
+        }
+        if (input_data->queue_type == MQ_ASYNC_QUEUE) g_async_queue_unlock(input_data->midi_async_queue);
+    }
+    if (!payloads && count < max && ring_buffer_pop(input_data->sysex_lane, &message))
+        convert_midi_message(input_data, message, &events[count++]);
+    if (count > 0) signal_room(&input_data->room);
+    return count;
 }
 
 /**
- * Sets a callback for MIDI input events.
+ * Retrieve all pending messages as :c:type:`MIDI_event` values, up to **max** events.
+ * Pays for synchronization once per call instead of once per message:
+ * a GLib asynchronous queue is locked once, a ring buffer position is updated once.
  *
- * :param input_data: :c:type:`MIDI_in_data` instance
- * :param callback: :c:type:`MIDI_callback` instance
- * :param user_data: an optional pointer to additional data that is passed
- *                   to the callback function whenever it is called.
+ * With :c:member:`mq_type_t.MQ_ASYNC_QUEUE` and :c:member:`mq_type_t.MQ_RING_BUFFER`
+ * a batch ends at an event with a payload, so it can be retrieved with :c:func:`pop_midi_sysex`.
+ * With :c:member:`mq_type_t.MQ_EVENT_RING` payloads are retrieved in the order of their events.
+ * With :c:member:`RMR_Port_config.priority_lanes` events are read by :c:func:`pop_lane_events`.
  *
- * :since: v0.1
+ * :param input_data: a :c:type:`MIDI_in_data` instance to read events from
+ * :param events: an array of at least **max** :c:type:`MIDI_event` instances to fill
+ * :param max: a maximal amount of events to read
+ * :param timeout: time in microseconds to wait for the first event,
+ *                 **0** to return immediately, a negative value to wait without a limit
+ *
+ * :returns: an amount of events read
+ *
+ * :since: v0.2
  */
-void set_MIDI_in_callback(
-    MIDI_in_data * input_data,
-    MIDI_callback callback,
-    void *user_data
-  ) {
-    // Exit if a callback is already set.
-    // Allows to detect code issues.
-    if ( input_data->using_callback ) {
-        slog("MIDI in", "callback function is already set.");
-        exit(1);
-        return;
+size_t pop_midi_event_batch(MIDI_in_data * input_data, MIDI_event * events, size_t max, long timeout) {
+    size_t count = 0;
+    MIDI_message * message;
+    if (max == 0) return 0;
+    // Lanes can't be waited on together with a GLib queue, they use a wakeup signal
+    if (input_data->queue_type == MQ_ASYNC_QUEUE && input_data->realtime_ring == NULL) {
+        g_async_queue_lock(input_data->midi_async_queue);
+        while (count < max) {
+            // Only the first message is waited for
+            if (count == 0 && timeout < 0)
+                message = g_async_queue_pop_unlocked(input_data->midi_async_queue);
+            else if (count == 0 && timeout > 0)
+                message = g_async_queue_timeout_pop_unlocked(input_data->midi_async_queue, timeout);
+            else
+                message = g_async_queue_try_pop_unlocked(input_data->midi_async_queue);
+            if (message == NULL) break;
+            resolve_coalesced_message(input_data, message);
+            if (convert_midi_message(input_data, message, &events[count++])) break;
+        }
+        g_async_queue_unlock(input_data->midi_async_queue);
+        if (count > 0) signal_room(&input_data->room);
+        record_dequeue_latency(input_data, events, count);
+        return count;
     }
-    // Exit if callback is NULL.
-    // Allows to detect code issues.
-    if ( !callback ) {
-        slog("MIDI in", "callback function value is invalid.");
-        exit(1);
-        return;
+    gint64 deadline = g_get_monotonic_time() + timeout;
+    while (1) {
+        if (input_data->realtime_ring) {
+            count = pop_lane_events(input_data, events, max);
+        } else if (input_data->queue_type == MQ_EVENT_RING) {
+            count = ring_buffer_pop_batch(input_data->midi_ring, events, max);
+            resolve_coalesced_events(input_data, events, count);
+        } else {
+            while (count < max && ring_buffer_pop(input_data->midi_ring, &message)) {
+                resolve_coalesced_message(input_data, message);
+                if (convert_midi_message(input_data, message, &events[count++])) break;
+            }
+        }
+        if (count > 0 || timeout == 0) break;
+        gint64 left = deadline - g_get_monotonic_time();
+        if (timeout > 0 && left <= 0) break;
+        // Ring buffers have no blocking primitive, wait for a wakeup signal
+        wait_for_midi_input(input_data, timeout > 0 ? left : -1);
     }
-    // Configure input data
-    input_data->user_callback = callback;
-    input_data->user_data = user_data;
-    input_data->using_callback = true;
+    if (count > 0) signal_room(&input_data->room);
+    record_dequeue_latency(input_data, events, count);
+    return count;
 }
 
 /**
- * Add an :c:type:`error_message` instance to :c:type:`MIDI_in_data` instance
+ * Retrieve a payload of an event read by :c:func:`pop_midi_event` with :c:data:`MIDI_EVENT_SYSEX`
+ * or :c:data:`MIDI_EVENT_LONG` flag: SysEx bytes or bytes of a long message, like a 14-bit controller.
+ * A caller owns a message and frees it with :c:func:`free_midi_message`.
  *
- * :param input_data: a :c:type:`MIDI_in_data` instance containing a queue to send an error to
- * :param etype: error type string, for example, "V0001", "S0001"
- * :param msg: error message
+ * :param input_data: a :c:type:`MIDI_in_data` instance to read a payload from
  *
- * :since: v0.1
+ * :returns: a :c:type:`MIDI_message` pointer or **NULL** when no payload is pending
+ *
+ * :since: v0.2
  */
-void enqueue_error(MIDI_in_data * input_data, char * etype, char * msg) {
-    error_message *err = g_new(error_message, 1);
-    strncpy(err->error_type, etype, ERROR_MSG_ETYPE_SIZE);
-    strncpy(err->message, msg, ERROR_MSG_TEXT_SIZE);
-    g_async_queue_push(input_data->error_async_queue, err);
+MIDI_message * pop_midi_sysex(MIDI_in_data * input_data) {
+    MIDI_message * message = NULL;
+    // A SysEx lane payload is kept by a read like in message queues,
+    // payloads of event ring messages are read in the order of their events
+    if (input_data->queue_type == MQ_EVENT_RING && input_data->pending_sysex == NULL) {
+        if (!ring_buffer_pop(input_data->sysex_ring, &message)) message = NULL;
+        else signal_room(&input_data->room);
+    } else {
+        message = input_data->pending_sysex;
+        input_data->pending_sysex = NULL;
+    }
+    return message;
 }
 
 /**
@@ -164,6 +1536,19 @@ void assign_error_queue(MIDI_in_data * input_data) {
     g_async_queue_ref(input_data->error_async_queue);
 }
 
+/**
+ * Create a wakeup eventfd, add to :c:type:`MIDI_in_data` instance
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance to add a descriptor to
+ *
+ * :since: v0.2
+ */
+void assign_wakeup_fd(MIDI_in_data * input_data) {
+    atomic_init(&input_data->wakeup_pending, false);
+    input_data->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (input_data->wakeup_fd < 0) slog("Start", "Unable to create a wakeup descriptor.");
+}
+
 /**
  * Fill :c:type:`Alsa_MIDI_data` struct instance
  *
@@ -180,6 +1565,19 @@ int init_amidi_data(Alsa_MIDI_data * amidi_data, mp_type_t port_type) {
     int result = 0;
     amidi_data->port_num = -1;
     amidi_data->vport = -1;
+    // An input queue is created by start_input_seq when needed
+    amidi_data->queue_id = -1;
+    amidi_data->timestamp_mode = TS_NONE;
+    amidi_data->threadless = false;
+    amidi_data->sched_policy = SCHED_OTHER;
+    amidi_data->sched_priority = 0;
+    amidi_data->cpu_affinity = NULL;
+    amidi_data->cpu_affinity_size = 0;
+    amidi_data->lock_memory = false;
+    amidi_data->time_callbacks = false;
+    reset_port_stats(&amidi_data->stats);
+    amidi_data->enqueue_latency = NULL;
+    amidi_data->dequeue_latency = NULL;
     if (port_type == MP_IN || port_type == MP_VIRTUAL_IN) {
         amidi_data->port_num = -1;
         amidi_data->vport = -1;
@@ -250,6 +1648,109 @@ int init_seq(
     return result;
 }
 
+/**
+ * Sets sizes of kernel event pools and client buffers of a sequencer.
+ * Bigger input pools and buffers let a client survive longer bursts
+ * without overruns, look at :c:func:`get_midi_input_overruns`.
+ *
+ * :param amidi_data: :c:type:`Alsa_MIDI_data` instance with an open sequencer
+ * :param port_config: an instance of port configuration: :c:type:`RMR_Port_config`,
+ *                     zero sizes keep Alsa defaults
+ *
+ * :returns: **0** on success, **-1** when any size couldn't be set
+ *
+ * :since: v0.2
+ */
+int configure_seq_buffers(Alsa_MIDI_data * amidi_data, RMR_Port_config * port_config) {
+    int result = 0;
+    if (port_config->client_pool_input && snd_seq_set_client_pool_input(amidi_data->seq, port_config->client_pool_input) < 0) {
+        slog("ALSA MIDI", "error setting a client input pool size.");
+        result = -1;
+    }
+    if (port_config->client_pool_output && snd_seq_set_client_pool_output(amidi_data->seq, port_config->client_pool_output) < 0) {
+        slog("ALSA MIDI", "error setting a client output pool size.");
+        result = -1;
+    }
+    if (port_config->input_buffer_size && snd_seq_set_input_buffer_size(amidi_data->seq, port_config->input_buffer_size) < 0) {
+        slog("ALSA MIDI", "error setting a client input buffer size.");
+        result = -1;
+    }
+    if (port_config->output_buffer_size && snd_seq_set_output_buffer_size(amidi_data->seq, port_config->output_buffer_size) < 0) {
+        slog("ALSA MIDI", "error setting a client output buffer size.");
+        result = -1;
+    }
+    return result;
+}
+
+/**
+ * Returns an amount of input overruns counted since a port was started.
+ * Every overrun means a kernel dropped one or more events
+ * before an input thread could read them. Safe to call from any thread.
+ *
+ * :param amidi_data: :c:type:`Alsa_MIDI_data` instance
+ *
+ * :returns: an amount of overruns
+ *
+ * :since: v0.2
+ */
+unsigned long get_midi_input_overruns(Alsa_MIDI_data * amidi_data) {
+    return atomic_load_explicit(&amidi_data->stats.input_overruns, memory_order_relaxed);
+}
+
+/**
+ * Returns an amount of messages :c:func:`send_midi_message` failed to send
+ * because a client output buffer or pool was full. Safe to call from any thread.
+ *
+ * :param amidi_data: :c:type:`Alsa_MIDI_data` instance
+ *
+ * :returns: an amount of overruns
+ *
+ * :since: v0.2
+ */
+unsigned long get_midi_output_overruns(Alsa_MIDI_data * amidi_data) {
+    return atomic_load_explicit(&amidi_data->stats.output_overruns, memory_order_relaxed);
+}
+
+/**
+ * Returns an amount of events a kernel dropped for a client,
+ * as reported by snd_seq_client_info_get_event_lost.
+ * Unlike :c:func:`get_midi_input_overruns` it counts single events.
+ *
+ * :param amidi_data: :c:type:`Alsa_MIDI_data` instance
+ *
+ * :returns: an amount of lost events, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int get_midi_lost_event_count(Alsa_MIDI_data * amidi_data) {
+    snd_seq_client_info_t * cinfo;
+    snd_seq_client_info_alloca(&cinfo);
+    if (snd_seq_get_client_info(amidi_data->seq, cinfo) < 0) return -1;
+    return snd_seq_client_info_get_event_lost(cinfo);
+}
+
+/**
+ * Copies port counters without stopping I/O. Safe to call from any thread,
+ * so a monitoring agent can read it periodically and compute rates from differences.
+ *
+ * :param amidi_data: :c:type:`Alsa_MIDI_data` instance
+ * :param input_data: a :c:type:`MIDI_in_data` instance used to measure a current queue depth,
+ *                    **NULL** for output ports
+ * :param snapshot: a :c:type:`MIDI_port_stats_snapshot` instance to fill
+ *
+ * :since: v0.2
+ */
+void get_midi_port_stats(Alsa_MIDI_data * amidi_data, MIDI_in_data * input_data, MIDI_port_stats_snapshot * snapshot) {
+    snapshot_port_stats(&amidi_data->stats, snapshot);
+    if (input_data == NULL) return;
+    if (input_data->queue_type == MQ_ASYNC_QUEUE) {
+        gint depth = g_async_queue_length(input_data->midi_async_queue);
+        snapshot->queue_depth = depth > 0 ? depth : 0;
+    } else if (input_data->midi_ring) {
+        snapshot->queue_depth = ring_buffer_count(input_data->midi_ring);
+    }
+}
+
 /**
  * Creates a named input queue, sets its tempo and other parameters.
  *
@@ -268,17 +1769,77 @@ int start_input_seq(
 ) {
     int result = 0;
     do {
+        amidi_data->threadless = port_config->threadless;
+        amidi_data->sched_policy = port_config->sched_policy;
+        amidi_data->sched_priority = port_config->sched_priority;
+        amidi_data->lock_memory = port_config->lock_memory;
+        amidi_data->time_callbacks = port_config->time_callbacks;
+        // A mask is copied, an input thread may be started after a config is gone
+        free(amidi_data->cpu_affinity);
+        amidi_data->cpu_affinity = NULL;
+        amidi_data->cpu_affinity_size = 0;
+        if (port_config->cpu_affinity) {
+            amidi_data->cpu_affinity = malloc(port_config->cpu_affinity_size);
+            if (amidi_data->cpu_affinity == NULL) {
+                slog("MIDI in", "error allocating an input thread CPU mask.");
+                result = -1;
+                break;
+            }
+            memcpy(amidi_data->cpu_affinity, port_config->cpu_affinity, port_config->cpu_affinity_size);
+            amidi_data->cpu_affinity_size = port_config->cpu_affinity_size;
+        }
         // Check if a pipe can be created, set trigger_fds.
         // Can break if there are too many open files in OS
         // or if too many file descriptors are used by a current process.
-        if (pipe(amidi_data->trigger_fds) == -1) {
+        // A pipe is only needed to interrupt an input thread.
+        if (!amidi_data->threadless && pipe(amidi_data->trigger_fds) == -1) {
             slog("MIDI in", "error creating pipe objects.");
             result = -1;
             break;
         }
+        amidi_data->timestamp_mode = port_config->timestamp_mode;
+        amidi_data->queue_start_ns = 0;
+        amidi_data->last_time_ns = 0;
+        amidi_data->last_tick = 0;
+        amidi_data->tick_duration = (double) port_config->queue_tempo / port_config->queue_ppq * 1e-6;
+        // Histograms of a previous start are replaced, so a restarted port doesn't leak them
+        free_latency_histogram(amidi_data->enqueue_latency);
+        free_latency_histogram(amidi_data->dequeue_latency);
+        amidi_data->enqueue_latency = NULL;
+        amidi_data->dequeue_latency = NULL;
+        // Latency is measured from an event time, so only real time stamps can be used
+        if (port_config->measure_latency) {
+            if (amidi_data->timestamp_mode != TS_REAL_TIME) {
+                slog("MIDI in", "latency is only measured with TS_REAL_TIME timestamps.");
+                result = -1;
+                break;
+            }
+            if (
+                init_latency_histogram(&amidi_data->enqueue_latency) != 0 ||
+                init_latency_histogram(&amidi_data->dequeue_latency) != 0
+            ) {
+                slog("MIDI in", "error allocating latency histograms.");
+                // Both are NULL or both are set, consumers check a single one
+                free_latency_histogram(amidi_data->enqueue_latency);
+                free_latency_histogram(amidi_data->dequeue_latency);
+                amidi_data->enqueue_latency = NULL;
+                amidi_data->dequeue_latency = NULL;
+                result = -1;
+                break;
+            }
+        }
+        // Ports without timestamps don't need a queue
+        if (amidi_data->timestamp_mode == TS_NONE) {
+            amidi_data->queue_id = -1;
+            break;
+        }
         // Create the input queue
-        #ifndef AVOID_TIMESTAMPING
         amidi_data->queue_id = snd_seq_alloc_named_queue(amidi_data->seq, queue_name);
+        if (amidi_data->queue_id < 0) {
+            slog("MIDI in", "error creating an input queue.");
+            result = -1;
+            break;
+        }
         // Set arbitrary tempo (mm=100) and resolution (240)
         snd_seq_queue_tempo_t * qtempo;
         snd_seq_queue_tempo_alloca(&qtempo);
@@ -288,12 +1849,27 @@ int start_input_seq(
         snd_seq_queue_tempo_set_ppq(qtempo, port_config->queue_ppq);
         snd_seq_set_queue_tempo(amidi_data->seq, amidi_data->queue_id, qtempo);
         snd_seq_drain_output(amidi_data->seq);
-        #endif
     }
     while (0);
     return result;
 }
 
+/**
+ * Starts an input queue and remembers its start time,
+ * so queue times of events can be converted to absolute time.
+ *
+ * :param amidi_data: :c:type:`Alsa_MIDI_data` instance
+ *
+ * :since: v0.2
+ */
+void start_input_queue(Alsa_MIDI_data * amidi_data) {
+    if (amidi_data->timestamp_mode == TS_NONE) return;
+    snd_seq_start_queue(amidi_data->seq, amidi_data->queue_id, NULL);
+    snd_seq_drain_output(amidi_data->seq);
+    // A queue time is zero when a start event is processed
+    amidi_data->queue_start_ns = get_monotonic_time_ns();
+}
+
 /**
  * Creates a MIDI event parser, a virtual port for virtual mode
  * and allocates a buffer for normal mode.
@@ -473,23 +2049,426 @@ void get_port_descriptor_by_id(
         port->port_info_client_id = snd_seq_port_info_get_client(pinfo);
         port->port_info_id = snd_seq_port_info_get_port(pinfo);
     } else {
-        slog("MIDI port retrieval", "unable to retrieve port information. Exiting.");
-        exit(1);
+        slog("MIDI port retrieval", "unable to retrieve port information. Exiting.");
+        exit(1);
+    }
+}
+
+/**
+ * Creates a MIDI event parser, a decoding buffer and a byte array
+ * used by the input thread to convert Alsa events to MIDI bytes.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int init_input_decoder(MIDI_in_data * input_data) {
+    int result = 0;
+    Alsa_MIDI_data * amidi_data = input_data->amidi_data;
+    do {
+        amidi_data->buffer_size = 32;
+        // Create a MIDI event parser, process init error
+        if (snd_midi_event_new(0, &amidi_data->coder) < 0) {
+            amidi_data->coder = 0;
+            enqueue_error(input_data, "S0001", "Error initializing MIDI event parser");
+            result = -1;
+            break;
+        }
+        amidi_data->buffer = (unsigned char *) malloc(amidi_data->buffer_size);
+        if (amidi_data->buffer == NULL) {
+            snd_midi_event_free(amidi_data->coder);
+            amidi_data->coder = 0;
+            slog("Alsa MIDI handler", "Error initializing buffer memory.");
+            result = -1;
+            break;
+        }
+        // A byte array keeps its memory between messages
+        input_data->bytes = g_array_sized_new(FALSE, FALSE, sizeof(unsigned char), amidi_data->buffer_size);
+        input_data->continue_sysex = false;
+        input_data->batch_count = 0;
+        // Reset MIDI encode / decode parsers
+        snd_midi_event_init(amidi_data->coder);
+        // Suppress running status messages
+        snd_midi_event_no_status(amidi_data->coder, 1);
+    } while (0);
+    return result;
+}
+
+/**
+ * Free an Alsa MIDI event parser, a decoding buffer and a byte array
+ * created by :c:func:`init_input_decoder`.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :since: v0.2
+ */
+void free_input_decoder(MIDI_in_data * input_data) {
+    if (input_data->amidi_data->coder) snd_midi_event_free(input_data->amidi_data->coder);
+    input_data->amidi_data->coder = 0;
+    if (input_data->amidi_data->buffer) free(input_data->amidi_data->buffer);
+    input_data->amidi_data->buffer = NULL;
+    if (input_data->bytes) g_array_free(input_data->bytes, true);
+    input_data->bytes = NULL;
+}
+
+/**
+ * Free an Alsa MIDI event parser, reset its value in :c:type:`MIDI_in_data` instance,
+ * set current :c:type:`MIDI_in_data` thread to **dummy_thread_id**
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :since: v0.1
+ */
+void deallocate_input_thread(struct MIDI_in_data * input_data) {
+    free_input_decoder(input_data);
+    input_data->amidi_data->thread = input_data->amidi_data->dummy_thread_id;
+}
+
+/**
+ * Passes a SysEx event payload to :c:member:`MIDI_in_data.user_sysex_chunk_callback`
+ * without copying it.
+ *
+ * :param in_data: a :c:type:`MIDI_in_data` instance
+ * :param ev: an Alsa sequencer event of SND_SEQ_EVENT_SYSEX type
+ *
+ * :since: v0.2
+ */
+void stream_sysex_chunk(MIDI_in_data * in_data, const snd_seq_event_t * ev) {
+    const unsigned char * chunk = (const unsigned char *) ev->data.ext.ptr;
+    long count = ev->data.ext.len;
+    unsigned char flags = 0;
+    if (count <= 0) return;
+    // A new message starts with 0xF0, or after a previous one was ended
+    if ( !in_data->streaming_sysex || chunk[0] == 0xF0 ) flags |= MIDI_SYSEX_CHUNK_START;
+    if ( chunk[count - 1] == 0xF7 ) flags |= MIDI_SYSEX_CHUNK_END;
+    in_data->streaming_sysex = !( flags & MIDI_SYSEX_CHUNK_END );
+    port_stats_add(&in_data->amidi_data->stats.bytes[MC_SYSEX], count);
+    if (flags & MIDI_SYSEX_CHUNK_END) port_stats_add(&in_data->amidi_data->stats.messages[MC_SYSEX], 1);
+    in_data->user_sysex_chunk_callback(chunk, count, flags, in_data->sysex_user_data);
+}
+
+/**
+ * Reads a time of a complete input message from an Alsa event
+ * and remembers it for a delta of the next one.
+ * Called from the input thread only.
+ *
+ * :param in_data: a :c:type:`MIDI_in_data` instance
+ * :param ev: an Alsa sequencer event
+ * :param time_ns: absolute time of a message in nanoseconds, set with :c:member:`ts_mode_t.TS_REAL_TIME`
+ * :param tick: a queue tick of a message, set with :c:member:`ts_mode_t.TS_TICK`
+ *
+ * :returns: time in seconds elapsed since the previous message
+ *
+ * :since: v0.2
+ */
+double stamp_input_event(MIDI_in_data * in_data, const snd_seq_event_t * ev, uint64_t * time_ns, unsigned int * tick) {
+    double timestamp = 0.0;
+    if ( in_data->amidi_data->timestamp_mode == TS_REAL_TIME ) {
+        // Queue time is relative to a queue start, integer math keeps it exact
+        * time_ns = in_data->amidi_data->queue_start_ns
+            + (uint64_t) ev->time.time.tv_sec * NANOSECONDS_IN_SECOND
+            + ev->time.time.tv_nsec;
+        if (!in_data->first_message)
+            timestamp = (int64_t)(* time_ns - in_data->amidi_data->last_time_ns) * 1e-9;
+        in_data->amidi_data->last_time_ns = * time_ns;
+        in_data->amidi_data->last_time = ev->time.time;
+    } else if ( in_data->amidi_data->timestamp_mode == TS_TICK ) {
+        // Ticks are passed as is, a delta is converted to seconds using a queue tempo
+        * tick = ev->time.tick;
+        if (!in_data->first_message)
+            timestamp = (int)(* tick - in_data->amidi_data->last_tick) * in_data->amidi_data->tick_duration;
+        in_data->amidi_data->last_tick = * tick;
+    }
+    in_data->first_message = false;
+    return timestamp;
+}
+
+/**
+ * Passes an event to a handler set by :c:func:`set_MIDI_in_typed_callback`
+ * with fields read straight from an Alsa event, skipping MIDI bytes.
+ * Called from the input thread only.
+ *
+ * :param in_data: a :c:type:`MIDI_in_data` instance
+ * :param ev: an Alsa sequencer event
+ *
+ * :returns: **true** when an event was handled, **false** when it takes a usual path
+ *
+ * :since: v0.2
+ */
+bool dispatch_typed_event(MIDI_in_data * in_data, const snd_seq_event_t * ev) {
+    // Rules of single-message events are shared with the fast decoder
+    const fast_event_rule * rule = &fast_event_rules[(unsigned char) ev->type];
+    if (rule->kind == FAST_EVENT_NONE) return false;
+    mf_type_t msg_type = get_filter_type(rule->status);
+    MIDI_typed_callback callback = in_data->typed_callbacks[msg_type];
+    if (callback == NULL) return false;
+    MIDI_typed_event event = { 0 };
+    long byte_count = 3;
+    event.type = msg_type;
+    event.source = ev->source;
+    // Note and control events keep a channel in the same place
+    if (rule->status < 0xF0) event.channel = ev->data.control.channel & 0x0F;
+    switch (rule->kind) {
+    case FAST_EVENT_NOTE:
+        event.number = ev->data.note.note & 0x7F;
+        event.value = ev->data.note.velocity & 0x7F;
+        break;
+    case FAST_EVENT_CONTROL:
+        event.number = ev->data.control.param & 0x7F;
+        event.value = ev->data.control.value & 0x7F;
+        break;
+    case FAST_EVENT_VALUE:
+        event.value = ev->data.control.value & 0x7F;
+        byte_count = 2;
+        break;
+    case FAST_EVENT_VALUE14:
+        event.value = ev->data.control.value & 0x3FFF;
+        break;
+    case FAST_EVENT_PITCHBEND:
+        event.value = ev->data.control.value;
+        break;
+    default:
+        byte_count = 1;
+        break;
+    }
+    uint64_t time_ns = 0;
+    unsigned int tick = 0;
+    stamp_input_event(in_data, ev, &time_ns, &tick);
+    event.time_ns = in_data->amidi_data->timestamp_mode == TS_TICK ? tick : time_ns;
+    MIDI_port_stats * stats = &in_data->amidi_data->stats;
+    mc_type_t msg_class = get_message_class(rule->status);
+    port_stats_add(&stats->messages[msg_class], 1);
+    port_stats_add(&stats->bytes[msg_class], byte_count);
+    if (in_data->amidi_data->enqueue_latency && in_data->amidi_data->timestamp_mode == TS_REAL_TIME) {
+        uint64_t now = get_monotonic_time_ns();
+        record_latency(in_data->amidi_data->enqueue_latency, now > time_ns ? now - time_ns : 0);
+    }
+    uint64_t callback_start = in_data->amidi_data->time_callbacks ? get_monotonic_time_ns() : 0;
+    callback(&event, in_data->typed_user_data[msg_type]);
+    if (callback_start) {
+        port_stats_add_shared(&stats->callback_calls, 1);
+        port_stats_add_shared(&stats->callback_ns, get_monotonic_time_ns() - callback_start);
+    }
+    return true;
+}
+
+/**
+ * Converts a single Alsa sequencer event to MIDI bytes, assembles SysEx messages
+ * and passes complete messages to a callback or a queue.
+ * Queued messages become visible after :c:func:`flush_input_batch` call.
+ *
+ * :param in_data: a :c:type:`MIDI_in_data` instance with an initialized decoder,
+ *                 look at :c:func:`init_input_decoder`
+ * :param ev: an Alsa sequencer event
+ *
+ * :since: v0.2
+ */
+void handle_alsa_event(MIDI_in_data * in_data, snd_seq_event_t * ev) {
+    long byte_count;
+    bool do_decode = false;
+    double timestamp = 0.0;
+    uint64_t time_ns = 0;
+    unsigned int tick = 0;
+    GArray * bytes = in_data->bytes;
+    // Messages are tagged with their origin, a port can have many senders
+    in_data->source = ev->source;
+    // Registered message types skip decoding, handlers get fields of an Alsa event
+    if (in_data->using_typed_callbacks && dispatch_typed_event(in_data, ev)) return;
+    // A complete message, either a decoding buffer or assembled SysEx chunks
+    const unsigned char * data = NULL;
+    long count = 0;
+    // Reset the array for input if no sysex message is continued
+    if ( !in_data->continue_sysex ) {
+        g_array_set_size(bytes, 0);
+    }
+    // Determine if event bytes should be decoded
+    switch ( ev->type ) {
+    case SND_SEQ_EVENT_PORT_SUBSCRIBED:
+        break;
+    case SND_SEQ_EVENT_PORT_UNSUBSCRIBED:
+        break;
+    // Unwanted message types are rejected by an input filter before this call
+    case SND_SEQ_EVENT_SYSEX:
+        // Streamed chunks are passed as is, no decoding needed
+        if (in_data->user_sysex_chunk_callback) {
+            stream_sysex_chunk(in_data, ev);
+            break;
+        }
+        if (ev->data.ext.len > in_data->amidi_data->buffer_size) {
+            in_data->amidi_data->buffer_size = ev->data.ext.len;
+            free( in_data->amidi_data->buffer );
+            in_data->amidi_data->buffer = (unsigned char *) malloc(
+              in_data->amidi_data->buffer_size
+            );
+            if ( in_data->amidi_data->buffer == NULL ) {
+                in_data->do_input = false;
+                slog("Alsa MIDI handler", "error resizing buffer memory.");
+                break;
+            }
+        }
+        do_decode = true;
+        break;
+
+    default:
+        do_decode = true;
+    }
+
+    if ( do_decode ) {
+        // Decode Alsa MIDI event to a byte buffer,
+        // short messages skip the generic parser
+        byte_count = decode_alsa_event_fast(ev, in_data->amidi_data->buffer);
+        if ( byte_count == 0 ) {
+            byte_count = snd_midi_event_decode(
+                in_data->amidi_data->coder,
+                in_data->amidi_data->buffer,
+                in_data->amidi_data->buffer_size,
+                ev
+            );
+        }
+        if ( byte_count < 0 ) port_stats_add(&in_data->amidi_data->stats.decode_errors, 1);
+        // Add a timestamp
+        if ( byte_count > 0 ) {
+            bool chunked = in_data->continue_sysex;
+            unsigned char last_byte = in_data->amidi_data->buffer[byte_count - 1];
+            in_data->continue_sysex = ( (ev->type == SND_SEQ_EVENT_SYSEX) && (last_byte != 0xF7) );
+            if ( chunked || in_data->continue_sysex ) {
+                // Append decoded bytes, continued sysex chunks are added after previous ones
+                g_array_append_vals(bytes, in_data->amidi_data->buffer, byte_count);
+                data = (unsigned char *) bytes->data;
+                count = bytes->len;
+            } else {
+                // A message decoded in one go is used in place
+                data = in_data->amidi_data->buffer;
+                count = byte_count;
+            }
+            // Calculate timestamps using ALSA sequencer event time data
+            if ( !in_data->continue_sysex ) {
+                timestamp = stamp_input_event(in_data, ev, &time_ns, &tick);
+            } else {
+                enqueue_error(
+                    in_data,
+                    "V0001",
+                    "Event parsing error or not a MIDI event"
+                );
+            }
+        }
+    }
+    if (count == 0 || in_data->continue_sysex) return;
+    MIDI_port_stats * stats = &in_data->amidi_data->stats;
+    count_port_message(stats, data, count);
+    if (data == (unsigned char *) bytes->data) port_stats_add(&stats->sysex_reassemblies, 1);
+    // Events carry a single time value, ticks replace nanoseconds in a tick mode
+    uint64_t event_time = in_data->amidi_data->timestamp_mode == TS_TICK ? tick : time_ns;
+    // An event time is compared to a moment a message is handed over
+    if (in_data->amidi_data->enqueue_latency && in_data->amidi_data->timestamp_mode == TS_REAL_TIME) {
+        uint64_t now = get_monotonic_time_ns();
+        record_latency(in_data->amidi_data->enqueue_latency, now > time_ns ? now - time_ns : 0);
+    }
+    // Callbacks are timed only on request, a clock read costs more than a counter update
+    MIDI_typed_callback sysex_callback = data[0] == 0xF0 ? in_data->typed_callbacks[MF_SYSEX] : NULL;
+    // Workers only get messages, the input thread keeps reading
+    if (
+        in_data->callback_pool && !sysex_callback &&
+        (in_data->user_lending_callback || in_data->user_event_callback || in_data->using_callback)
+    ) {
+        hand_off_callback(in_data, data, count, timestamp, event_time);
+        return;
+    }
+    uint64_t callback_start = 0;
+    if (
+        in_data->amidi_data->time_callbacks &&
+        (sysex_callback || in_data->user_lending_callback || in_data->user_event_callback || in_data->using_callback)
+    ) callback_start = get_monotonic_time_ns();
+    // Send data to a callback or a queue
+    if (sysex_callback) {
+        // Assembled bytes are lent for the duration of a call
+        MIDI_typed_event event = { 0 };
+        event.time_ns = event_time;
+        event.type = MF_SYSEX;
+        event.source = in_data->source;
+        event.sysex = data;
+        event.sysex_count = count;
+        sysex_callback(&event, in_data->typed_user_data[MF_SYSEX]);
+    } else if (in_data->user_lending_callback) {
+        // Bytes are lent for the duration of a call, nothing is copied
+        in_data->user_lending_callback(timestamp, event_time, data, count, in_data->user_data);
+    } else if (in_data->user_event_callback) {
+        // SysEx bytes are lent for the duration of a call
+        MIDI_event event;
+        fill_midi_event(&event, data, count, event_time);
+        event.source = in_data->source;
+        in_data->user_event_callback(
+            event,
+            (event.flags & MIDI_EVENT_PAYLOAD) ? data : NULL,
+            in_data->user_data
+        );
+    } else if (in_data->using_callback) {
+        // A callback owns a buffer copy
+        unsigned char * buf = calloc(count, sizeof(unsigned char));
+        if (buf == NULL) {
+            enqueue_error(in_data, "S0004", "Unable to allocate a callback message");
+        } else {
+            memcpy(buf, data, count);
+            MIDI_callback callback = (MIDI_callback) in_data->user_callback;
+            callback(timestamp, buf, count, in_data->user_data);
+        }
+    } else if (in_data->fan_out) {
+        fan_out_input_message(in_data, data, count, event_time);
+    } else {
+        queue_input_message(in_data, data, count, timestamp, time_ns, tick);
+    }
+    if (callback_start) {
+        port_stats_add_shared(&stats->callback_calls, 1);
+        port_stats_add_shared(&stats->callback_ns, get_monotonic_time_ns() - callback_start);
     }
 }
 
 /**
- * Free an Alsa MIDI event parser, reset its value in :c:type:`MIDI_in_data` instance,
- * set current :c:type:`MIDI_in_data` thread to **dummy_thread_id**
+ * Reads and handles every event buffered by the Alsa sequencer,
+ * then publishes resulting messages to a consumer at once.
+ * Events already read from the kernel are taken from a user-space buffer,
+ * the kernel is asked for more only when that buffer is empty.
+ * Messages are also published every :c:data:`MIDI_INPUT_BATCH_SIZE` events,
+ * so a consumer doesn't wait for a long burst to end.
  *
- * :param input_data: a :c:type:`MIDI_in_data` instance
+ * :param in_data: a :c:type:`MIDI_in_data` instance with an initialized decoder,
+ *                 look at :c:func:`init_input_decoder`
  *
- * :since: v0.1
+ * :returns: an amount of handled events
+ *
+ * :since: v0.2
  */
-void deallocate_input_thread(struct MIDI_in_data * input_data) {
-    snd_midi_event_free(input_data->amidi_data->coder);
-    input_data->amidi_data->coder = 0;
-    input_data->amidi_data->thread = input_data->amidi_data->dummy_thread_id;
+int drain_alsa_events(MIDI_in_data * in_data) {
+    int event_count = 0;
+    int result;
+    snd_seq_event_t * ev;
+    // Parked values are older than new events
+    offer_parked_events(in_data);
+    while ( in_data->do_input && snd_seq_event_input_pending( in_data->amidi_data->seq, 1 ) > 0 ) {
+        result = snd_seq_event_input( in_data->amidi_data->seq, &ev );
+        if ( result == -ENOSPC ) {
+            // Events were dropped by a kernel, count it and let a consumer know
+            port_stats_add(&in_data->amidi_data->stats.input_overruns, 1);
+            enqueue_error(in_data, "S0003", "Input buffer overrun, events were lost");
+            continue;
+        } else if ( result <= 0 ) {
+            slog("Alsa MIDI handler", "unknown MIDI input error.");
+            break;
+        }
+        // Unwanted events are dropped before they are decoded
+        if ( !accept_alsa_event(&in_data->filter, ev) ) {
+            port_stats_add(&in_data->amidi_data->stats.filtered, 1);
+            continue;
+        }
+        // A channel state is read from an Alsa event, before messages are passed on
+        if ( in_data->channel_state ) update_state_tracker(in_data->channel_state, ev);
+        handle_alsa_event(in_data, ev);
+        if (++event_count % MIDI_INPUT_BATCH_SIZE == 0) flush_input_batch(in_data);
+    }
+    flush_input_batch(in_data);
+    return event_count;
 }
 
 /**
@@ -501,40 +2480,13 @@ void deallocate_input_thread(struct MIDI_in_data * input_data) {
  */
 static void * alsa_MIDI_handler( void * ptr ) {
     struct MIDI_in_data * in_data = ptr;
-    long byte_count;
-    double time;
-    bool continue_sysex = false;
-    bool do_decode = false;
     int poll_fd_count;
     struct pollfd * poll_fds;
-    // "bytes" pointer and timestamp value
-    // are used to send the message to a queue.
-    // They are reset at each received MIDI message.
-    GArray * bytes;
-    double timestamp = 0.0;
-    bytes = g_array_sized_new(FALSE, FALSE, sizeof(unsigned char), 0);
-    // Prepare a sequencer event record to convert a MIDI event to bytes
-    snd_seq_event_t * ev;
-    in_data->amidi_data->buffer_size = 32;
-    // Create a MIDI event parser, process init error
-    int result = snd_midi_event_new(0, &in_data->amidi_data->coder);
-    if (result < 0) {
-        in_data->do_input = false;
-        enqueue_error(in_data, "S0001", "Error initializing MIDI event parser");
-        return 0;
-    }
-    unsigned char *buffer = (unsigned char *)malloc(in_data->amidi_data->buffer_size);
-    if ( buffer == NULL ) {
+    // Create a MIDI event parser and buffers
+    if (init_input_decoder(in_data) != 0) {
         in_data->do_input = false;
-        snd_midi_event_free(in_data->amidi_data->coder);
-        in_data->amidi_data->coder = 0;
-        slog("Alsa MIDI handler", "Error initializing buffer memory.");
         return 0;
     }
-    // Reset MIDI encode / decode parsers
-    snd_midi_event_init(in_data->amidi_data->coder);
-    // Suppress running status messages
-    snd_midi_event_no_status(in_data->amidi_data->coder, 1);
     // Get the number of poll descriptors
     poll_fd_count = 1 + snd_seq_poll_descriptors_count(
       in_data->amidi_data->seq, POLLIN
@@ -546,154 +2498,219 @@ static void * alsa_MIDI_handler( void * ptr ) {
     // Handle MIDI input while no errors or
     // interruptions are present
     while ( in_data->do_input ) {
-        // Poll MIDI file descriptor
-        if ( snd_seq_event_input_pending( in_data->amidi_data->seq, 1 ) == 0 ) {
-            // No data pending
-            if ( poll( poll_fds, poll_fd_count, -1) >= 0 ) {
-                if ( poll_fds[0].revents & POLLIN ) {
-                    bool dummy;
-                    int res = read( poll_fds[0].fd, &dummy, sizeof(dummy) );
-                    (void) res;
-                }
+        // Handle every buffered event in one go
+        drain_alsa_events(in_data);
+        if ( !in_data->do_input ) break;
+        // No data pending, wait for more,
+        // parked events are retried even when no new events arrive
+        int timeout = in_data->parked && in_data->parked->count > 0 ? PARKED_EVENTS_RETRY_INTERVAL : -1;
+        if ( poll( poll_fds, poll_fd_count, timeout) >= 0 ) {
+            if ( poll_fds[0].revents & POLLIN ) {
+                bool dummy;
+                int res = read( poll_fds[0].fd, &dummy, sizeof(dummy) );
+                (void) res;
             }
-            continue;
-        }
-        // If here, there should be data.
-        result = snd_seq_event_input( in_data->amidi_data->seq, &ev );
-        if ( result == -ENOSPC ) {
-            slog("Alsa MIDI handler", "input buffer overrun.");
-            continue;
-        } else if ( result <= 0 ) {
-            slog("Alsa MIDI handler", "unknown MIDI input error.");
-            continue;
-        }
-        // Creates new array for input if no sysex message is continued
-        if ( !continue_sysex ) {
-            bytes = g_array_sized_new(FALSE, FALSE, sizeof(unsigned char), 0);
         }
-        // Determine if event bytes should be decoded
-        do_decode = false;
-        switch ( ev->type ) {
-        case SND_SEQ_EVENT_PORT_SUBSCRIBED:
-            break;
-        case SND_SEQ_EVENT_PORT_UNSUBSCRIBED:
-            break;
-        // MIDI time code
-        case SND_SEQ_EVENT_QFRAME:
-            if ( !( in_data->ignore_flags & 0x02 ) ) do_decode = true;
-            break;
-        // 0xF9 ... MIDI timing tick
-        case SND_SEQ_EVENT_TICK:
-            if ( !( in_data->ignore_flags & 0x02 ) ) do_decode = true;
-            break;
-        // 0xF8 ... MIDI timing (clock) tick
-        case SND_SEQ_EVENT_CLOCK:
-            if ( !( in_data->ignore_flags & 0x02 ) ) do_decode = true;
+    }
+    // Destroy thread data
+    deallocate_input_thread(in_data);
+    // Stop thread with no error
+    return 0;
+}
+
+/**
+ * Makes a thread created with attributes start on CPUs of a byte mask.
+ * A cpu_set_t is built here only, so RMR headers don't need _GNU_SOURCE
+ * unless a thread is pinned.
+ *
+ * :param attr: thread attributes
+ * :param mask: a byte mask, bit N % 8 of byte N / 8 allows CPU N
+ * :param mask_size: length of mask in bytes
+ *
+ * :returns: **0** on success, **-1** on an error or without _GNU_SOURCE
+ *
+ * :since: v0.2
+ */
+int set_thread_attr_affinity(pthread_attr_t * attr, const unsigned char * mask, size_t mask_size) {
+#ifdef _GNU_SOURCE
+    int result = 0;
+    size_t cpu_count = mask_size * 8;
+    size_t set_size = CPU_ALLOC_SIZE(cpu_count);
+    cpu_set_t * cpu_set = CPU_ALLOC(cpu_count);
+    if (cpu_set == NULL) return -1;
+    CPU_ZERO_S(set_size, cpu_set);
+    for (size_t cpu = 0; cpu < cpu_count; cpu++)
+        if (mask[cpu / 8] & (1 << (cpu % 8))) CPU_SET_S(cpu, set_size, cpu_set);
+    // Attributes keep a copy of a set
+    if (pthread_attr_setaffinity_np(attr, set_size, cpu_set) != 0) result = -1;
+    CPU_FREE(cpu_set);
+    return result;
+#else
+    (void) attr;
+    (void) mask;
+    (void) mask_size;
+    slog("Alsa MIDI in", "input thread CPU affinity needs _GNU_SOURCE defined before RMR headers.");
+    return -1;
+#endif
+}
+
+/**
+ * Starts an input queue and an input thread running :c:func:`alsa_MIDI_handler`.
+ * In a threadless mode only prepares a decoder for :c:func:`process_midi_input`.
+ *
+ * :param amidi_data: :c:type:`Alsa_MIDI_data` instance
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int start_input_thread(Alsa_MIDI_data * amidi_data, MIDI_in_data * input_data) {
+    int result = 0;
+    do {
+        // Wait for old thread to stop, if still running
+        if ( !pthread_equal(amidi_data->thread, amidi_data->dummy_thread_id) )
+            pthread_join(amidi_data->thread, NULL);
+        // Keep input buffers and stacks resident, a lock is process-wide and isn't undone on close
+        if (amidi_data->lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            slog("Alsa MIDI in", "unable to lock memory, check RLIMIT_MEMLOCK.");
+            result = -1;
             break;
-        // Active sensing
-        case SND_SEQ_EVENT_SENSING:
-            if ( !( in_data->ignore_flags & 0x04 ) ) do_decode = true;
+        }
+        // Start the input queue
+        start_input_queue(amidi_data);
+        // Workers are ready before the first message is handed off
+        if (input_data->callback_pool && start_callback_pool(input_data->callback_pool, run_callback_job, input_data) != 0) {
+            slog("Alsa MIDI in", "unable to start callback workers.");
+            result = -1;
             break;
-        case SND_SEQ_EVENT_SYSEX:
-            if (in_data->ignore_flags & 0x01) break;
-            if (ev->data.ext.len > in_data->amidi_data->buffer_size) {
-                in_data->amidi_data->buffer_size = ev->data.ext.len;
-                free( buffer );
-                buffer = (unsigned char *) malloc(
-                  in_data->amidi_data->buffer_size
-                );
-                if ( buffer == NULL ) {
-                    in_data->do_input = false;
-                    slog("Alsa MIDI handler", "error resizing buffer memory.");
-                    break;
-                }
+        }
+        if (amidi_data->threadless) {
+            // Events are decoded by the calling thread
+            if (init_input_decoder(input_data) != 0) {
+                result = -1;
+                break;
             }
-            do_decode = true;
+            input_data->do_input = true;
             break;
-
-        default:
-            do_decode = true;
-        }
-
-        if ( do_decode ) {
-            // Decode Alsa MIDI event to a byte buffer
-            byte_count = snd_midi_event_decode(in_data->amidi_data->coder, buffer, in_data->amidi_data->buffer_size, ev);
-            // Add a timestamp
-            if ( byte_count > 0 ) {
-                size_t sysex_array_pos;
-                if ( !continue_sysex ) sysex_array_pos = 0;
-                else sysex_array_pos = bytes->len;
-                for(; sysex_array_pos < byte_count; sysex_array_pos++) {
-                    g_array_append_val(bytes, buffer[sysex_array_pos]);
-                }
-                unsigned char last_byte = get_last_bytearray_byte(bytes);
-                continue_sysex = ( (ev->type == SND_SEQ_EVENT_SYSEX) && (last_byte != 0xF7) );
-                // Calculate a timestamp using ALSA sequencer event time data
-                if ( !continue_sysex ) {
-                    timestamp = 0.0;
-                    snd_seq_real_time_t x = ev->time.time;
-                    // Temp var y is timespec because computation requires signed types,
-                    // while snd_seq_real_time_t has unsigned types.
-                    struct timespec y;
-                    // Perform the carry for the later subtraction by updating y.
-                    y.tv_nsec = in_data->amidi_data->last_time.tv_nsec;
-                    y.tv_sec = in_data->amidi_data->last_time.tv_sec;
-                    if ( x.tv_nsec < y.tv_nsec ) {
-                        int nsec = (y.tv_nsec - (int)x.tv_nsec) / NANOSECONDS_IN_SECOND + 1;
-                        y.tv_nsec -= NANOSECONDS_IN_SECOND * nsec;
-                        y.tv_sec += nsec;
-                    }
-                    if (x.tv_nsec - y.tv_nsec > NANOSECONDS_IN_SECOND) {
-                        int nsec = ((int)x.tv_nsec - y.tv_nsec) / NANOSECONDS_IN_SECOND;
-                        y.tv_nsec += NANOSECONDS_IN_SECOND * nsec;
-                        y.tv_sec -= nsec;
-                    }
-                    // Compute the time difference
-                    time = (int)x.tv_sec - y.tv_sec + ((int)x.tv_nsec - y.tv_nsec) * 1e-9;
-                    in_data->amidi_data->last_time = ev->time.time;
-                    if (in_data->first_message == true) in_data->first_message = false;
-                    else timestamp = time;
-                } else {
-                    enqueue_error(
-                        in_data,
-                        "V0001",
-                        "Event parsing error or not a MIDI event"
-                    );
-                }
-            }
         }
-        if (bytes->len == 0 || continue_sysex) continue;
-        // Convert current message buffer
-        unsigned char * buf = NULL;
-        long count = bytes->len;
-        if (count > 0) {
-            // Allocate memory for an unsigned char pointer buffer.
-            buf = calloc(bytes->len, sizeof(unsigned char));
-            // Copy bytes
-            for (unsigned int msg_byte_idx = 0; msg_byte_idx < bytes->len; msg_byte_idx++) {
-                buf[msg_byte_idx] = g_array_index(bytes, unsigned char, msg_byte_idx);
+        // Create and configure a thread attributes object
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+        // Real-time policies need explicit attributes, a thread doesn't inherit them
+        if (amidi_data->sched_policy != SCHED_OTHER) {
+            struct sched_param param = { .sched_priority = amidi_data->sched_priority };
+            pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+            if (
+                pthread_attr_setschedpolicy(&attr, amidi_data->sched_policy) != 0 ||
+                pthread_attr_setschedparam(&attr, &param) != 0
+            ) {
+                pthread_attr_destroy(&attr);
+                slog("Alsa MIDI in", "invalid input thread scheduling policy or priority.");
+                result = -1;
+                break;
             }
-        }
-        // Free GArray memory
-        g_array_free(bytes, true);
-        // Send data to a callback or a queue
-        if (in_data->using_callback) {
-            MIDI_callback callback = (MIDI_callback) in_data->user_callback;
-            callback(timestamp, buf, count, in_data->user_data);
         } else {
-            MIDI_message * message = g_new(MIDI_message, 1);
-            message->buf = buf;
-            message->count = count;
-            message->timestamp = timestamp;
-            g_async_queue_push(in_data->midi_async_queue, message);
+            pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+        }
+        // A thread starts on selected CPUs, so it never handles input elsewhere
+        if (
+            amidi_data->cpu_affinity &&
+            set_thread_attr_affinity(&attr, amidi_data->cpu_affinity, amidi_data->cpu_affinity_size) != 0
+        ) {
+            pthread_attr_destroy(&attr);
+            slog("Alsa MIDI in", "invalid input thread CPU affinity.");
+            result = -1;
+            break;
+        }
+        // Mark input thread as started
+        input_data->do_input = true;
+        // Passing input data to a thread.
+        // Create a thread
+        int err = pthread_create(&amidi_data->thread, &attr, alsa_MIDI_handler, input_data);
+        // Destroy thread attributes object
+        pthread_attr_destroy(&attr);
+        if (err) {
+            input_data->do_input = false;
+            if (err == EPERM) slog("Alsa MIDI in", "not permitted to use input thread scheduling policy, check RLIMIT_RTPRIO.");
+            if (err == EINVAL && amidi_data->cpu_affinity) slog("Alsa MIDI in", "input thread CPU affinity has no available CPUs.");
+            result = -1;
         }
+    } while (0);
+    return result;
+}
+
+/**
+ * Stops an input thread started by :c:func:`start_input_thread` and waits for it to finish.
+ * In a threadless mode frees a decoder.
+ *
+ * :param amidi_data: :c:type:`Alsa_MIDI_data` instance
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :since: v0.2
+ */
+void stop_input_thread(Alsa_MIDI_data * amidi_data, MIDI_in_data * input_data) {
+    if (input_data == NULL || !input_data->do_input) return;
+    input_data->do_input = false;
+    if (amidi_data->threadless) {
+        deallocate_input_thread(input_data);
+    } else {
+        // Interrupt a poll call in the input thread
+        int res = write(amidi_data->trigger_fds[1], &input_data->do_input, sizeof(input_data->do_input));
+        // TODO is there a point in this call?
+        (void) res;
+        // Wait for old thread to stop, if still running
+        if (!pthread_equal(amidi_data->thread, amidi_data->dummy_thread_id))
+            pthread_join(amidi_data->thread, NULL);
     }
-    // Free the memory, allocated for a buffer
-    if (buffer) free(buffer);
-    // Destroy thread data
-    deallocate_input_thread(in_data);
-    // Stop thread with no error
-    return 0;
+    // No jobs are added anymore, workers run pending ones and stop
+    if (input_data->callback_pool) stop_callback_pool(input_data->callback_pool);
+}
+
+/**
+ * Returns an amount of sequencer poll descriptors used to wait for input
+ * in a threadless mode, look at :c:member:`RMR_Port_config.threadless`.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :returns: an amount of descriptors
+ *
+ * :since: v0.2
+ */
+int get_midi_input_poll_descriptors_count(MIDI_in_data * input_data) {
+    return snd_seq_poll_descriptors_count(input_data->amidi_data->seq, POLLIN);
+}
+
+/**
+ * Fills sequencer poll descriptors used to wait for input in a threadless mode.
+ * When any of them is readable, call :c:func:`process_midi_input`.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ * :param poll_fds: an array to fill
+ * :param space: a size of poll_fds array, look at :c:func:`get_midi_input_poll_descriptors_count`
+ *
+ * :returns: an amount of filled descriptors
+ *
+ * :since: v0.2
+ */
+int get_midi_input_poll_descriptors(MIDI_in_data * input_data, struct pollfd * poll_fds, unsigned int space) {
+    return snd_seq_poll_descriptors(input_data->amidi_data->seq, poll_fds, space, POLLIN);
+}
+
+/**
+ * Decodes pending sequencer events and passes messages to a callback or a queue
+ * in the calling thread. Doesn't block, used in a threadless mode only.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance of an open threadless port
+ *
+ * :returns: an amount of handled events, **-1** when a port has no threadless input
+ *
+ * :since: v0.2
+ */
+int process_midi_input(MIDI_in_data * input_data) {
+    if (!input_data->do_input || !input_data->amidi_data->threadless) return -1;
+    return drain_alsa_events(input_data);
 }
 
 /**
@@ -723,11 +2740,11 @@ int open_virtual_port(Alsa_MIDI_data * amidi_data, const char *port_name, MIDI_i
                 SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION
             );
             snd_seq_port_info_set_midi_channels(pinfo, 16);
-            #ifndef AVOID_TIMESTAMPING
-            snd_seq_port_info_set_timestamping(pinfo, 1);
-            snd_seq_port_info_set_timestamp_real(pinfo, 1);
-            snd_seq_port_info_set_timestamp_queue(pinfo, amidi_data->queue_id);
-            #endif
+            if (amidi_data->timestamp_mode != TS_NONE) {
+                snd_seq_port_info_set_timestamping(pinfo, 1);
+                snd_seq_port_info_set_timestamp_real(pinfo, amidi_data->timestamp_mode == TS_REAL_TIME);
+                snd_seq_port_info_set_timestamp_queue(pinfo, amidi_data->queue_id);
+            }
             snd_seq_port_info_set_name(pinfo, port_name);
             amidi_data->vport = snd_seq_create_port(amidi_data->seq, pinfo);
             if (amidi_data->vport < 0) {
@@ -739,31 +2756,13 @@ int open_virtual_port(Alsa_MIDI_data * amidi_data, const char *port_name, MIDI_i
         }
         // Open a thread to handle a virtual port input
         if (input_data->do_input == false) {
-            // Wait for old thread to stop, if still running
-            if ( !pthread_equal(amidi_data->thread, amidi_data->dummy_thread_id) )
-                pthread_join(amidi_data->thread, NULL);
-            // Start the input queue
-            #ifndef AVOID_TIMESTAMPING
-            snd_seq_start_queue(amidi_data->seq, amidi_data->queue_id, NULL);
-            snd_seq_drain_output(amidi_data->seq);
-            #endif
-            // Start our MIDI input thread.
-            pthread_attr_t attr;
-            pthread_attr_init(&attr);
-            pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-            pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
-            // Mark data input thread is active
-            input_data->do_input = true;
-            int err = pthread_create(&amidi_data->thread, &attr, alsa_MIDI_handler, input_data);
-            pthread_attr_destroy(&attr);
             // Exit if thread init failed
-            if ( err ) {
+            if ( start_input_thread(amidi_data, input_data) != 0 ) {
                 if ( amidi_data->subscription ) {
                     snd_seq_unsubscribe_port( amidi_data->seq, amidi_data->subscription );
                     snd_seq_port_subscribe_free( amidi_data->subscription );
                     amidi_data->subscription = 0;
                 }
-                input_data->do_input = false;
                 slog("Alsa MIDI input", "error starting MIDI input thread while creating a virtual port.");
                 result = -1;
                 break;
@@ -834,13 +2833,19 @@ int send_midi_message(Alsa_MIDI_data * amidi_data, const unsigned char * message
             offset += event_decoding_result;
             // Send the event.
             int event_output_result = snd_seq_event_output( amidi_data->seq, &ev );
-            if (event_output_result < 0) {
+            if (event_output_result == -EAGAIN) {
+                port_stats_add(&amidi_data->stats.output_overruns, 1);
+                slog("send_midi_message", "output buffer overrun.");
+                result = -1;
+                break;
+            } else if (event_output_result < 0) {
                 slog("send_midi_message", "error sending MIDI message to port.");
                 result = -1;
                 break;
             }
         }
         snd_seq_drain_output(amidi_data->seq);
+        if (result == 0) count_port_message(&amidi_data->stats, message, size);
     } while(0);
     return result;
 }
@@ -1040,11 +3045,11 @@ int open_port(mp_type_t port_type, unsigned int port_number, const char *port_na
                 snd_seq_port_info_set_capability( pinfo, SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE );
                 snd_seq_port_info_set_type( pinfo, SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION );
                 snd_seq_port_info_set_midi_channels(pinfo, 16);
-                #ifndef AVOID_TIMESTAMPING
-                snd_seq_port_info_set_timestamping( pinfo, 1 );
-                snd_seq_port_info_set_timestamp_real( pinfo, 1 );
-                snd_seq_port_info_set_timestamp_queue( pinfo, amidi_data->queue_id );
-                #endif
+                if ( amidi_data->timestamp_mode != TS_NONE ) {
+                    snd_seq_port_info_set_timestamping( pinfo, 1 );
+                    snd_seq_port_info_set_timestamp_real( pinfo, amidi_data->timestamp_mode == TS_REAL_TIME );
+                    snd_seq_port_info_set_timestamp_queue( pinfo, amidi_data->queue_id );
+                }
                 snd_seq_port_info_set_name( pinfo,  port_name );
                 amidi_data->vport = snd_seq_create_port( amidi_data->seq, pinfo );
                 if (amidi_data->vport < 0) {
@@ -1118,30 +3123,13 @@ int open_port(mp_type_t port_type, unsigned int port_number, const char *port_na
         }
         // Start an input thread if it wasn't started yet
         if ((port_type == MP_IN || port_type == MP_VIRTUAL_IN) && input_data->do_input == false) {
-            // Start the input queue
-            #ifndef AVOID_TIMESTAMPING
-            snd_seq_start_queue(amidi_data->seq, amidi_data->queue_id, NULL);
-            snd_seq_drain_output(amidi_data->seq);
-            #endif
-            // Create and configure a thread attributes object
-            pthread_attr_t attr;
-            pthread_attr_init(&attr);
-            pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-            pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
-            // Mark input thread as started
-            input_data->do_input = true;
-            // Passing input data to a thread.
-            // Create a thread
-            int err = pthread_create(&amidi_data->thread, &attr, alsa_MIDI_handler, input_data);
-            // Destroy thread attributes object
-            pthread_attr_destroy(&attr);
-            if (err) {
+            if (start_input_thread(amidi_data, input_data) != 0) {
                 snd_seq_unsubscribe_port(amidi_data->seq, amidi_data->subscription);
                 snd_seq_port_subscribe_free(amidi_data->subscription);
                 amidi_data->subscription = 0;
-                input_data->do_input = false;
                 slog("Alsa MIDI in", "error starting MIDI input thread.");
-                exit(1);
+                result = -1;
+                break;
             }
         }
         // Record that port is connected in a provided amidi_data instance
@@ -1150,6 +3138,48 @@ int open_port(mp_type_t port_type, unsigned int port_number, const char *port_na
     return result;
 }
 
+/**
+ * Subscribes an open input port to one more sender, so a single port,
+ * sequencer client and input thread can receive messages from many sources.
+ * Messages are tagged with a sender address, look at :c:func:`get_midi_input_source`.
+ *
+ * :param amidi_data: :c:type:`Alsa_MIDI_data` instance of an open input port
+ * :param client: a sender client id
+ * :param port: a sender port id
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int connect_midi_input(Alsa_MIDI_data * amidi_data, int client, int port) {
+    int result = 0;
+    if (amidi_data->vport < 0 || snd_seq_connect_from(amidi_data->seq, amidi_data->vport, client, port) < 0) {
+        slog("Alsa MIDI in", "error connecting an input source.");
+        result = -1;
+    }
+    return result;
+}
+
+/**
+ * Removes a subscription made by :c:func:`connect_midi_input`.
+ *
+ * :param amidi_data: :c:type:`Alsa_MIDI_data` instance of an open input port
+ * :param client: a sender client id
+ * :param port: a sender port id
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int disconnect_midi_input(Alsa_MIDI_data * amidi_data, int client, int port) {
+    int result = 0;
+    if (amidi_data->vport < 0 || snd_seq_disconnect_from(amidi_data->seq, amidi_data->vport, client, port) < 0) {
+        slog("Alsa MIDI in", "error disconnecting an input source.");
+        result = -1;
+    }
+    return result;
+}
+
 /**
  * Closes input or output port, works for both virtual and not ports
  *
@@ -1176,28 +3206,16 @@ void close_port(Alsa_MIDI_data * amidi_data, MIDI_in_data * input_data, int mode
                 amidi_data->subscription = 0;
             }
             // Stop the input queue
-            #ifndef AVOID_TIMESTAMPING
-            snd_seq_stop_queue(amidi_data->seq, amidi_data->queue_id, NULL);
-            snd_seq_drain_output(amidi_data->seq);
-            #endif
+            if (amidi_data->timestamp_mode != TS_NONE) {
+                snd_seq_stop_queue(amidi_data->seq, amidi_data->queue_id, NULL);
+                snd_seq_drain_output(amidi_data->seq);
+            }
             amidi_data->port_connected = false;
         }
     }
     // Stop thread to avoid triggering the callback,
     // while the port is intended to be closed
-    if (mode == SND_SEQ_OPEN_INPUT && input_data->do_input) {
-        input_data->do_input = false;
-        int res = write(
-            amidi_data->trigger_fds[1],
-            &input_data->do_input,
-            sizeof( input_data->do_input )
-        );
-        // TODO is there a point in this call?
-        (void) res;
-        // Wait for old thread to stop, if still running
-        if ( !pthread_equal( amidi_data->thread, amidi_data->dummy_thread_id ) )
-            pthread_join( amidi_data->thread, NULL );
-    }
+    if (mode == SND_SEQ_OPEN_INPUT) stop_input_thread(amidi_data, input_data);
 }
 
 /**
@@ -1241,29 +3259,24 @@ int destroy_midi_input(Alsa_MIDI_data * amidi_data, MIDI_in_data * input_data) {
     // Close port connection if it exists
     close_port(amidi_data, input_data, SND_SEQ_OPEN_OUTPUT);
     // Shutdown the input thread.
-    if (input_data != NULL && input_data->do_input) {
-        input_data->do_input = false;
-        int res = write(amidi_data->trigger_fds[1], &input_data->do_input, sizeof(input_data->do_input));
-        // TODO is there a point in this call?
-        (void) res;
-        // Wait for old thread to stop, if still running
-        if (!pthread_equal(amidi_data->thread, amidi_data->dummy_thread_id))
-            pthread_join(amidi_data->thread, NULL);
-    }
+    stop_input_thread(amidi_data, input_data);
     // Do cleanup
-    close(amidi_data->trigger_fds[0]);
-    close(amidi_data->trigger_fds[1]);
+    if (amidi_data->trigger_fds[0] >= 0) close(amidi_data->trigger_fds[0]);
+    if (amidi_data->trigger_fds[1] >= 0) close(amidi_data->trigger_fds[1]);
     int port_delete_result;
     if (amidi_data->vport >= 0) {
         port_delete_result = snd_seq_delete_port(amidi_data->seq, amidi_data->vport);
         if (port_delete_result < 0) result = -1;
     }
-    #ifndef AVOID_TIMESTAMPING
-    int queue_free_result = snd_seq_free_queue(amidi_data->seq, amidi_data->queue_id);
-    if (queue_free_result < 0) result = -1;
-    #endif
+    if (amidi_data->queue_id >= 0) {
+        int queue_free_result = snd_seq_free_queue(amidi_data->seq, amidi_data->queue_id);
+        if (queue_free_result < 0) result = -1;
+    }
     int seq_closing_result = snd_seq_close(amidi_data->seq);
     if (seq_closing_result < 0) result = -1;
+    free_latency_histogram(amidi_data->enqueue_latency);
+    free_latency_histogram(amidi_data->dequeue_latency);
+    free(amidi_data->cpu_affinity);
     free(amidi_data);
     return result;
 }
@@ -1309,18 +3322,187 @@ void set_client_name(Alsa_MIDI_data *amidi_data, const char *client_name) {
  */
 int prepare_input_data_with_queues(MIDI_in_data ** input_data) {
     int result = 0;
-    // Allocate memory for input_data
+    // Allocate zeroed memory for input_data
     * input_data = NULL;
-    * input_data = malloc(sizeof(MIDI_in_data));
+    * input_data = calloc(1, sizeof(MIDI_in_data));
     if (input_data == NULL) slog("Start", "Unable to allocate memory for MIDI_in_data instance.");
     // Assign a queue for passing MIDI messages
+    (*input_data)->queue_type = MQ_ASYNC_QUEUE;
+    (*input_data)->first_message = true;
     assign_midi_queue(*input_data);
     // Assign a queue for passing error messages
     assign_error_queue(*input_data);
+    // Create a descriptor to wait for input on
+    assign_wakeup_fd(*input_data);
+    init_room_signal(&(*input_data)->room);
     //
     return result;
 }
 
+// TODO this is done for ordering only, improve!
+void destroy_input_data(MIDI_in_data * input_data);
+
+/**
+ * Allocates memory for :c:type:`MIDI_in_data` instance,
+ * assigns a MIDI message queue selected by :c:member:`RMR_Port_config.queue_type`
+ * and an error queue.
+ *
+ * :param input_data: a double pointer used to allocate memory for a :c:type:`MIDI_in_data` instance
+ * :param port_config: an instance of port configuration: :c:type:`RMR_Port_config`
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int prepare_input_data(MIDI_in_data ** input_data, RMR_Port_config * port_config) {
+    int result = 0;
+    do {
+        // Allocate zeroed memory for input_data
+        * input_data = calloc(1, sizeof(MIDI_in_data));
+        if (* input_data == NULL) {
+            slog("Start", "Unable to allocate memory for MIDI_in_data instance.");
+            result = -1;
+            break;
+        }
+        (*input_data)->queue_type = port_config->queue_type;
+        (*input_data)->queue_capacity = port_config->queue_capacity;
+        (*input_data)->overflow_policy = port_config->overflow_policy;
+        (*input_data)->first_message = true;
+        set_midi_input_filter(*input_data, &port_config->filter);
+        // Assign a queue for passing MIDI messages
+        if (port_config->queue_type == MQ_RING_BUFFER) {
+            if (init_ring_buffer(&(*input_data)->midi_ring, port_config->ring_size, sizeof(MIDI_message *)) != 0) {
+                slog("Start", "Unable to allocate memory for an input ring buffer.");
+                free(* input_data);
+                * input_data = NULL;
+                result = -1;
+                break;
+            }
+        } else if (port_config->queue_type == MQ_EVENT_RING) {
+            if (
+                init_ring_buffer(&(*input_data)->midi_ring, port_config->ring_size, sizeof(MIDI_event)) != 0 ||
+                init_ring_buffer(&(*input_data)->sysex_ring, port_config->sysex_ring_size, sizeof(MIDI_message *)) != 0
+            ) {
+                slog("Start", "Unable to allocate memory for an input ring buffer.");
+                free_ring_buffer((*input_data)->midi_ring);
+                free(* input_data);
+                * input_data = NULL;
+                result = -1;
+                break;
+            }
+        } else {
+            assign_midi_queue(*input_data);
+        }
+        // Preallocate messages, so the input thread doesn't allocate them
+        if (port_config->pool_size > 0) {
+            if (init_message_pool(&(*input_data)->message_pool, port_config->pool_size, port_config->pool_message_size) != 0) {
+                slog("Start", "Unable to allocate memory for an input message pool.");
+                free_ring_buffer((*input_data)->midi_ring);
+                free_ring_buffer((*input_data)->sysex_ring);
+                if ((*input_data)->midi_async_queue) {
+                    g_async_queue_unref((*input_data)->midi_async_queue);
+                    g_async_queue_unref((*input_data)->midi_async_queue);
+                }
+                free(* input_data);
+                * input_data = NULL;
+                result = -1;
+                break;
+            }
+        }
+        // Assign a queue for passing error messages
+        assign_error_queue(*input_data);
+        // Create a descriptor to wait for input on
+        assign_wakeup_fd(*input_data);
+        // Create a descriptor the input thread waits for room on
+        init_room_signal(&(*input_data)->room);
+        if (
+            // The input thread takes the oldest messages from a consumer's side of rings
+            (port_config->overflow_policy == OP_DROP_OLDEST && (*input_data)->midi_ring &&
+                ring_buffer_enable_discard((*input_data)->midi_ring) != 0) ||
+            (port_config->overflow_policy == OP_COALESCE && init_parked_events(&(*input_data)->parked) != 0) ||
+            (port_config->coalesce_controllers && init_coalesce_table(&(*input_data)->coalesce) != 0) ||
+            (port_config->track_channel_state && init_state_tracker(&(*input_data)->channel_state) != 0) ||
+            (port_config->fan_out && init_fan_out(&(*input_data)->fan_out) != 0) ||
+            (port_config->callback_workers > 0 && init_callback_pool(
+                &(*input_data)->callback_pool, port_config->callback_workers, port_config->callback_queue_size
+            ) != 0) ||
+            (port_config->pool_size > 0 &&
+                ((*input_data)->spare_messages = calloc(port_config->pool_size, sizeof(MIDI_message *))) == NULL) ||
+            // A SysEx lane is separate from payloads of an event ring, so events are never paired with lane messages
+            (port_config->priority_lanes && (
+                init_ring_buffer(
+                    &(*input_data)->realtime_ring, port_config->realtime_ring_size,
+                    port_config->queue_type == MQ_EVENT_RING ? sizeof(MIDI_event) : sizeof(MIDI_message *)
+                ) != 0 ||
+                init_ring_buffer(&(*input_data)->sysex_lane, port_config->sysex_ring_size, sizeof(MIDI_message *)) != 0
+            ))
+        ) {
+            slog("Start", "Unable to allocate memory for input queues.");
+            destroy_input_data(* input_data);
+            * input_data = NULL;
+            result = -1;
+            break;
+        }
+    } while (0);
+    return result;
+}
+
+/**
+ * Deallocates :c:type:`MIDI_in_data` instance, its queues and pending messages.
+ * Call it after :c:func:`destroy_midi_input`, when the input thread is stopped.
+ *
+ * :param input_data: a :c:type:`MIDI_in_data` instance
+ *
+ * :since: v0.2
+ */
+void destroy_input_data(MIDI_in_data * input_data) {
+    MIDI_message * message;
+    error_message * err;
+    if (input_data == NULL) return;
+    // Free messages nobody has read, amidi_data may be already destroyed,
+    // so queues are read directly instead of pop_midi_message
+    if (input_data->queue_type == MQ_RING_BUFFER) {
+        while (ring_buffer_pop(input_data->midi_ring, &message)) free_midi_message(message);
+    } else if (input_data->midi_async_queue) {
+        while ((message = g_async_queue_try_pop(input_data->midi_async_queue)) != NULL) free_midi_message(message);
+    }
+    if (input_data->realtime_ring) {
+        if (input_data->queue_type != MQ_EVENT_RING)
+            while (ring_buffer_pop(input_data->realtime_ring, &message)) free_midi_message(message);
+        free_ring_buffer(input_data->realtime_ring);
+    }
+    if (input_data->sysex_ring) {
+        while (ring_buffer_pop(input_data->sysex_ring, &message)) free_midi_message(message);
+        free_ring_buffer(input_data->sysex_ring);
+    }
+    if (input_data->sysex_lane) {
+        while (ring_buffer_pop(input_data->sysex_lane, &message)) free_midi_message(message);
+        free_ring_buffer(input_data->sysex_lane);
+    }
+    if (input_data->pending_sysex) free_midi_message(input_data->pending_sysex);
+    if (input_data->midi_ring) free_ring_buffer(input_data->midi_ring);
+    if (input_data->message_pool) free_message_pool(input_data->message_pool);
+    free(input_data->spare_messages);
+    free_parked_events(input_data->parked);
+    free_coalesce_table(input_data->coalesce);
+    free_state_tracker(input_data->channel_state);
+    free_fan_out(input_data->fan_out);
+    free_callback_pool(input_data->callback_pool);
+    if (input_data->midi_async_queue) {
+        // Drop both references taken by assign_midi_queue
+        g_async_queue_unref(input_data->midi_async_queue);
+        g_async_queue_unref(input_data->midi_async_queue);
+    }
+    if (input_data->error_async_queue) {
+        while ((err = g_async_queue_try_pop(input_data->error_async_queue)) != NULL) free_error_message(err);
+        g_async_queue_unref(input_data->error_async_queue);
+        g_async_queue_unref(input_data->error_async_queue);
+    }
+    if (input_data->wakeup_fd >= 0) close(input_data->wakeup_fd);
+    free_room_signal(&input_data->room);
+    free(input_data);
+}
+
 /**
  * A wrapper function for a initializing a virtual output MIDI port.
  *
@@ -1339,6 +3521,7 @@ int start_virtual_output_port(Alsa_MIDI_data **amidi_data, RMR_Port_config * por
     init_amidi_data(*amidi_data, port_config->port_type);
     // Open an Alsa seq interface, assign it to :c:type:`Alsa_MIDI_data` instance
     init_seq(*amidi_data, port_config->client_name, port_config->port_type);
+    if (configure_seq_buffers(*amidi_data, port_config) != 0) result = -1;
     // Open Alsa seq interface with a "virtual output" port
     prepare_output(true, *amidi_data, port_config->port_name);
     //
@@ -1363,6 +3546,7 @@ int start_output_port(Alsa_MIDI_data ** amidi_data, RMR_Port_config * port_confi
     init_amidi_data(*amidi_data, port_config->port_type);
     // Open an Alsa seq interface, assign it to :c:type:`Alsa_MIDI_data` instance
     init_seq(*amidi_data, port_config->client_name, port_config->port_type);
+    if (configure_seq_buffers(*amidi_data, port_config) != 0) result = -1;
     prepare_output(false, *amidi_data, 0);
     //
     return result;
@@ -1374,7 +3558,7 @@ int start_output_port(Alsa_MIDI_data ** amidi_data, RMR_Port_config * port_confi
  * :param amidi_data: a double pointer to :c:type:`Alsa_MIDI_data` instance
  * :param port_config: an instance of port configuration: :c:type:`RMR_Port_config`
  *
- * :returns: **0** on success
+ * :returns: **0** on success, **-1** on an error
  *
  * :since: v0.1
  */
@@ -1386,7 +3570,8 @@ int start_virtual_input_port(Alsa_MIDI_data **amidi_data, RMR_Port_config * port
     init_amidi_data(*amidi_data, port_config->port_type);
     // Open an Alsa seq interface, assign it to :c:type:`Alsa_MIDI_data` instance
     init_seq(*amidi_data, port_config->client_name, port_config->port_type);
-    start_input_seq(*amidi_data, port_config->queue_name, port_config);
+    if (configure_seq_buffers(*amidi_data, port_config) != 0) result = -1;
+    if (start_input_seq(*amidi_data, port_config->queue_name, port_config) != 0) result = -1;
     //
     return result;
 }
@@ -1397,7 +3582,7 @@ int start_virtual_input_port(Alsa_MIDI_data **amidi_data, RMR_Port_config * port
  * :param amidi_data: a double pointer to :c:type:`Alsa_MIDI_data` instance
  * :param port_config: an instance of port configuration: :c:type:`RMR_Port_config`
  *
- * :returns: **0** on success
+ * :returns: **0** on success, **-1** on an error
  *
  * :since: v0.1
  */
@@ -1409,7 +3594,8 @@ int start_input_port(Alsa_MIDI_data **amidi_data, RMR_Port_config * port_config)
     init_amidi_data(*amidi_data, port_config->port_type);
     // Open an Alsa seq interface, assign it to :c:type:`Alsa_MIDI_data` instance
     init_seq(*amidi_data, port_config->client_name, port_config->port_type);
-    start_input_seq(*amidi_data, port_config->queue_name, port_config);
+    if (configure_seq_buffers(*amidi_data, port_config) != 0) result = -1;
+    if (start_input_seq(*amidi_data, port_config->queue_name, port_config) != 0) result = -1;
 
     return result;
 }
@@ -1435,6 +3621,52 @@ int reset_port_config(RMR_Port_config * port_config, mp_type_t port_type) {
     // for input and virtual input modes only
     port_config->queue_tempo = QUEUE_TEMPO;
     port_config->queue_ppq = QUEUE_STATUS_PPQ;
+    // Input queue config, GLib asynchronous queue is used by default
+    port_config->queue_type = MQ_ASYNC_QUEUE;
+    port_config->ring_size = RING_BUFFER_SIZE;
+    // A GLib queue isn't limited, new messages are dropped when a ring is full
+    port_config->queue_capacity = 0;
+    port_config->overflow_policy = OP_DROP_NEWEST;
+    // All messages are accepted by default
+    reset_midi_filter_config(&port_config->filter);
+    // Every controller value is queued by default
+    port_config->coalesce_controllers = false;
+    // Channel states are not tracked by default
+    port_config->track_channel_state = false;
+    // Messages go to a single input queue by default
+    port_config->fan_out = false;
+    // Callbacks run in the input thread by default
+    port_config->callback_workers = 0;
+    port_config->callback_queue_size = CALLBACK_QUEUE_SIZE;
+    port_config->sysex_ring_size = SYSEX_RING_SIZE;
+    // All messages share one queue by default
+    port_config->priority_lanes = false;
+    port_config->realtime_ring_size = REALTIME_RING_SIZE;
+    // Message pool config, messages are allocated on heap by default
+    port_config->pool_size = 0;
+    port_config->pool_message_size = POOL_MESSAGE_SIZE;
+    // Timestamp config, AVOID_TIMESTAMPING turns timestamps off by default
+    #ifdef AVOID_TIMESTAMPING
+    port_config->timestamp_mode = TS_NONE;
+    #else
+    port_config->timestamp_mode = TS_REAL_TIME;
+    #endif
+    // Input is handled by a dedicated thread by default
+    port_config->threadless = false;
+    // Input thread config, an inherited scheduling and affinity are kept by default
+    port_config->sched_policy = SCHED_OTHER;
+    port_config->sched_priority = 0;
+    port_config->cpu_affinity = NULL;
+    port_config->cpu_affinity_size = 0;
+    port_config->lock_memory = false;
+    // Kernel pools and client buffers keep Alsa defaults
+    port_config->client_pool_input = 0;
+    port_config->client_pool_output = 0;
+    port_config->input_buffer_size = 0;
+    port_config->output_buffer_size = 0;
+    // Callbacks and latencies aren't timed by default
+    port_config->time_callbacks = false;
+    port_config->measure_latency = false;
     // Configure port based on its type
     port_config->client_name = "N/A";
     port_config->port_name = "N/A";
@@ -1608,3 +3840,6 @@ int get_full_port_name(char * port_name, unsigned int port_number, mp_type_t por
 
   return result;
 }
+
+// A single thread serving many threadless input ports
+#include "reactor.h"
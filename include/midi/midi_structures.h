@@ -4,6 +4,11 @@
 #include <glib.h>
 #include "asoundlib.h"
 #include "typedefs.h"
+#include "ring_buffer.h"
+#include "port_stats.h"
+#include "latency_histogram.h"
+#include "event_decoding.h"
+#include "input_filter.h"
 
 /**
  * A constant that defines a maximum port name length
@@ -34,6 +39,19 @@ typedef struct MIDI_port {
     int port_info_id;
 } MIDI_port;
 
+/** Continuous controller events parked by :c:member:`overflow_policy_t.OP_COALESCE`, defined in coalescing.h */
+struct MIDI_parked_events;
+/** Latest values of continuous controllers, defined in coalescing.h */
+struct MIDI_coalesce_table;
+/** States of 16 channels, defined in channel_state.h */
+struct MIDI_state_tracker;
+/** Consumers of an input port, defined in fan_out.h */
+struct MIDI_fan_out;
+/** Workers running input callbacks, defined in callback_pool.h */
+struct MIDI_callback_pool;
+/** A pool of preallocated messages, defined in message_pool.h */
+struct MIDI_message_pool;
+
 /**
  * A structure that initializes a port.
  * It contains a port type, names for seq interface, queue tempo and ppq for input queues.
@@ -47,6 +65,68 @@ typedef struct RMR_Port_config {
     unsigned int queue_tempo;
     // Look at snd_seq_queue_tempo_set_ppq for the reference
     int queue_ppq;
+    // Input queue type, look at mq_type_t for the reference
+    mq_type_t queue_type;
+    // Amount of ring buffer slots for MQ_RING_BUFFER and MQ_EVENT_RING, rounded up to a power of two
+    size_t ring_size;
+    // Amount of SysEx payload slots for MQ_EVENT_RING and of a SysEx lane, rounded up to a power of two
+    size_t sysex_ring_size;
+    // Pass realtime and SysEx messages through their own lanes, read before and after other messages
+    bool priority_lanes;
+    // Amount of realtime lane slots, rounded up to a power of two
+    size_t realtime_ring_size;
+    // Maximal amount of messages in MQ_ASYNC_QUEUE, 0 doesn't limit it; rings hold ring_size messages
+    size_t queue_capacity;
+    // What to do when an input queue is full, look at overflow_policy_t for the reference
+    overflow_policy_t overflow_policy;
+    // Messages accepted by an input port, look at MIDI_filter_config for the reference
+    MIDI_filter_config filter;
+    // Keep only the latest unread value of every controller, pitch bend and pressure in an input queue
+    bool coalesce_controllers;
+    // Keep a state of 16 channels readable without locks, look at get_midi_channel_state
+    bool track_channel_state;
+    // Publish messages to consumers added with add_midi_consumer instead of an input queue
+    bool fan_out;
+    // Amount of threads running input callbacks, 0 runs callbacks in the input thread
+    unsigned int callback_workers;
+    // Amount of pending callbacks of a worker, rounded up to a power of two
+    size_t callback_queue_size;
+    // Amount of preallocated input messages, 0 disables a message pool; the input thread then
+    // allocates no messages, but MQ_ASYNC_QUEUE still allocates a GLib list node per message
+    size_t pool_size;
+    // Payload capacity of a preallocated message, longer messages are allocated on heap
+    size_t pool_message_size;
+    // Input timestamp mode, look at ts_mode_t for the reference
+    ts_mode_t timestamp_mode;
+    // Don't start an input thread, input is handled by process_midi_input calls
+    bool threadless;
+    // Input thread scheduling policy: SCHED_OTHER, SCHED_FIFO or SCHED_RR
+    int sched_policy;
+    // Input thread priority, used with SCHED_FIFO and SCHED_RR
+    int sched_priority;
+    // Input thread CPUs as a byte mask, bit N % 8 of byte N / 8 allows CPU N; NULL keeps an inherited affinity.
+    // A thread starts bound to them, a mask is copied when a port is opened.
+    // Pinning needs _GNU_SOURCE defined before RMR headers are included, a port isn't opened otherwise
+    const unsigned char * cpu_affinity;
+    // Length of a cpu_affinity mask in bytes
+    size_t cpu_affinity_size;
+    // Lock process memory with mlockall(MCL_CURRENT | MCL_FUTURE) before input is started, so it's never paged out.
+    // A lock applies to the whole process, all its threads and later allocations, and it stays
+    // after a port is closed; applications owning their memory policy leave it unset and call mlockall themselves
+    bool lock_memory;
+    // Amount of kernel input event cells of a client, 0 keeps an Alsa default
+    size_t client_pool_input;
+    // Amount of kernel output event cells of a client, 0 keeps an Alsa default
+    size_t client_pool_output;
+    // Size of a client input buffer in bytes, 0 keeps an Alsa default
+    size_t input_buffer_size;
+    // Size of a client output buffer in bytes, 0 keeps an Alsa default
+    size_t output_buffer_size;
+    // Measure time spent in user callbacks, costs two clock reads per message
+    bool time_callbacks;
+    // Record input latency histograms, costs a clock read per message.
+    // Needs TS_REAL_TIME, a port with other timestamp modes isn't opened
+    bool measure_latency;
 } RMR_Port_config;
 
 /**
@@ -60,8 +140,100 @@ typedef struct MIDI_message {
     long count;
     /** Time in seconds elapsed since the previous message */
     double timestamp;
+    /** Absolute CLOCK_MONOTONIC time in nanoseconds, **0** when a port has no timestamping */
+    uint64_t time_ns;
+    /** A queue tick, set when a port uses :c:member:`ts_mode_t.TS_TICK` */
+    unsigned int tick;
+    /** A sequencer client and port a message was received from */
+    snd_seq_addr_t source;
+    /** A pool owning this message, **NULL** for messages allocated on heap */
+    struct MIDI_message_pool * pool;
 } MIDI_message;
 
+/** Inline payload capacity of :c:type:`MIDI_event`, fits any non-SysEx MIDI message */
+#define MIDI_EVENT_INLINE_SIZE 4
+/** :c:member:`MIDI_event.flags` bit: a payload is SysEx and is passed out of line */
+#define MIDI_EVENT_SYSEX 0x01
+/** :c:member:`MIDI_event.flags` bit: a payload is a non-SysEx message longer than
+    :c:data:`MIDI_EVENT_INLINE_SIZE`, like a decoded 14-bit controller, and is passed out of line */
+#define MIDI_EVENT_LONG 0x02
+/** :c:member:`MIDI_event.flags` mask of bits marking an event with a payload passed out of line */
+#define MIDI_EVENT_PAYLOAD (MIDI_EVENT_SYSEX | MIDI_EVENT_LONG)
+
+/**
+ * A compact fixed-size MIDI message, copied by value.
+ * Channel, system common and realtime messages are stored inline,
+ * SysEx and long message payloads are passed separately, look at :c:func:`pop_midi_sysex`.
+ */
+typedef struct MIDI_event {
+    union {
+        /** Absolute CLOCK_MONOTONIC time in nanoseconds, **0** when a port has no timestamping.
+            A delta between events is an exact integer difference. */
+        uint64_t time_ns;
+        /** A queue tick, valid when a port uses :c:member:`ts_mode_t.TS_TICK` */
+        uint64_t tick;
+    };
+    union {
+        /** Message bytes, valid when no :c:data:`MIDI_EVENT_PAYLOAD` flag is set */
+        unsigned char bytes[MIDI_EVENT_INLINE_SIZE];
+        /** Payload length, valid when a :c:data:`MIDI_EVENT_PAYLOAD` flag is set */
+        uint32_t sysex_count;
+    };
+    /** Amount of used bytes in :c:member:`MIDI_event.bytes`, 0 for events with a payload */
+    unsigned char count;
+    /** Event flags, like :c:data:`MIDI_EVENT_SYSEX` and :c:data:`MIDI_EVENT_LONG` */
+    unsigned char flags;
+    /** A sequencer client and port an event was received from */
+    snd_seq_addr_t source;
+} MIDI_event;
+
+_Static_assert(sizeof(MIDI_event) <= 16, "MIDI_event should fit in 16 bytes");
+
+/** :c:type:`MIDI_sysex_chunk_callback` flag: a chunk starts a SysEx message */
+#define MIDI_SYSEX_CHUNK_START 0x01
+/** :c:type:`MIDI_sysex_chunk_callback` flag: a chunk ends a SysEx message */
+#define MIDI_SYSEX_CHUNK_END 0x02
+
+/**
+ * A function definition for processing :c:type:`MIDI_event` callbacks.
+ * **sysex** points to a SysEx or a long message payload of :c:member:`MIDI_event.sysex_count` bytes,
+ * it is only valid during a call; it is **NULL** for inline events.
+ */
+typedef void ( * MIDI_event_callback ) (MIDI_event event, const unsigned char * sysex, void * user_data);
+
+/**
+ * A message with fields taken straight from an Alsa event, without MIDI bytes,
+ * passed to :c:type:`MIDI_typed_callback` handlers.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_typed_event {
+    /** Absolute CLOCK_MONOTONIC time in nanoseconds, or a queue tick with :c:member:`ts_mode_t.TS_TICK` */
+    uint64_t time_ns;
+    /** A velocity, a controller value, a program, a pressure, a pitch bend from -8192 to 8191,
+        a song position from 0 to 16383, a song or a time code quarter frame.
+        A note on with a zero velocity is not turned into a note off */
+    int value;
+    /** A message type */
+    mf_type_t type;
+    /** A channel from 0 to 15 of channel messages */
+    unsigned char channel;
+    /** A note of note and key pressure messages, a controller of control changes */
+    unsigned char number;
+    /** A sequencer client and port an event was received from */
+    snd_seq_addr_t source;
+    /** SysEx bytes, only valid during a call; **NULL** for other types */
+    const unsigned char * sysex;
+    /** Length of sysex */
+    long sysex_count;
+} MIDI_typed_event;
+
+/**
+ * A function definition for handlers of a single message type,
+ * look at :c:func:`set_MIDI_in_typed_callback`. **event** is only valid during a call.
+ */
+typedef void ( * MIDI_typed_callback ) (const MIDI_typed_event * event, void * user_data);
+
 /**
  * A structure to hold variables
  * related to the ALSA API implementation.
@@ -89,37 +261,158 @@ typedef struct Alsa_MIDI_data {
     snd_seq_real_time_t last_time;
     /** An input queue is needed to get timestamped events */
     int queue_id;
+    /** CLOCK_MONOTONIC time in nanoseconds when an input queue was started,
+        queue times of events are added to it */
+    uint64_t queue_start_ns;
+    /** Absolute time of the last message in nanoseconds, used to compute deltas */
+    uint64_t last_time_ns;
+    /** A queue tick of the last message, used to compute deltas in :c:member:`ts_mode_t.TS_TICK` mode */
+    unsigned int last_tick;
+    /** Duration of a queue tick in seconds, derived from a queue tempo and PPQ */
+    double tick_duration;
+    /** Input timestamp mode, copied from :c:member:`RMR_Port_config.timestamp_mode` */
+    ts_mode_t timestamp_mode;
+    /** Input is handled by :c:func:`process_midi_input` calls instead of a thread,
+        copied from :c:member:`RMR_Port_config.threadless` */
+    bool threadless;
+    /** Input thread scheduling policy, copied from :c:member:`RMR_Port_config.sched_policy` */
+    int sched_policy;
+    /** Input thread priority, copied from :c:member:`RMR_Port_config.sched_priority` */
+    int sched_priority;
+    /** Input thread CPUs, a copy of a :c:member:`RMR_Port_config.cpu_affinity` mask or **NULL** */
+    unsigned char * cpu_affinity;
+    /** Length of cpu_affinity in bytes */
+    size_t cpu_affinity_size;
+    /** Lock process memory, copied from :c:member:`RMR_Port_config.lock_memory` */
+    bool lock_memory;
+    /** Time user callbacks, copied from :c:member:`RMR_Port_config.time_callbacks` */
+    bool time_callbacks;
+    /** Port counters, look at :c:func:`get_midi_port_stats` */
+    MIDI_port_stats stats;
+    /** Latencies from an Alsa event time to a callback call or a queue push,
+        **NULL** unless :c:member:`RMR_Port_config.measure_latency` is set */
+    MIDI_latency_histogram * enqueue_latency;
+    /** Latencies from an Alsa event time to a consumer reading a queue,
+        **NULL** unless :c:member:`RMR_Port_config.measure_latency` is set */
+    MIDI_latency_histogram * dequeue_latency;
     /** File descriptors set by a pipe call in "start_input_seq" function. */
     int trigger_fds[2];
     /** Tells if a MIDI port is connected, set by :c:func:`open_port` */
     bool port_connected;
 } Alsa_MIDI_data;
 
+/** A maximal amount of input events published to a consumer at once */
+#define MIDI_INPUT_BATCH_SIZE 64
+
 /**
  * A struct to be passed to a :c:func:`pthread_create` call.
  */
 typedef struct MIDI_in_data {
     /** A GLib asynchronous que to store MIDI messages */
     GAsyncQueue * midi_async_queue;
+    /** A queue type used to pass MIDI messages, set from :c:member:`RMR_Port_config.queue_type` */
+    mq_type_t queue_type;
+    /** A lock-free ring of :c:type:`MIDI_message` pointers, used instead of
+        :c:member:`MIDI_in_data.midi_async_queue` with :c:member:`mq_type_t.MQ_RING_BUFFER`,
+        or a ring of :c:type:`MIDI_event` values with :c:member:`mq_type_t.MQ_EVENT_RING` */
+    MIDI_ring_buffer * midi_ring;
+    /** A lock-free ring of :c:type:`MIDI_message` pointers holding payloads of SysEx
+        and other long messages for :c:member:`mq_type_t.MQ_EVENT_RING` */
+    MIDI_ring_buffer * sysex_ring;
+    /** A realtime lane, set when :c:member:`RMR_Port_config.priority_lanes` is set:
+        a lock-free ring of :c:type:`MIDI_event` values with :c:member:`mq_type_t.MQ_EVENT_RING`,
+        of :c:type:`MIDI_message` pointers otherwise */
+    MIDI_ring_buffer * realtime_ring;
+    /** A SysEx lane, set when :c:member:`RMR_Port_config.priority_lanes` is set:
+        a lock-free ring of :c:type:`MIDI_message` pointers with any queue type */
+    MIDI_ring_buffer * sysex_lane;
+    /** A SysEx payload of the last event read by :c:func:`pop_midi_event`
+        from a message queue, returned by :c:func:`pop_midi_sysex` */
+    MIDI_message * pending_sysex;
+    /** Preallocated messages used instead of heap allocations, set when
+        :c:member:`RMR_Port_config.pool_size` is not zero */
+    struct MIDI_message_pool * message_pool;
+    /** Pooled messages the input thread dropped itself, reused before taking
+        new ones from :c:member:`MIDI_in_data.message_pool` */
+    MIDI_message ** spare_messages;
+    /** Amount of messages in :c:member:`MIDI_in_data.spare_messages` */
+    size_t spare_count;
+    /** A maximal amount of messages in :c:member:`MIDI_in_data.midi_async_queue`,
+        **0** doesn't limit it; set from :c:member:`RMR_Port_config.queue_capacity` */
+    size_t queue_capacity;
+    /** An amount of messages in :c:member:`MIDI_in_data.midi_async_queue` seen by the input thread
+        at the last publication, a consumer can only make it smaller */
+    size_t queue_length;
+    /** What the input thread does when a queue is full, set from :c:member:`RMR_Port_config.overflow_policy` */
+    overflow_policy_t overflow_policy;
+    /** Events waiting for room in a queue with :c:member:`overflow_policy_t.OP_COALESCE` */
+    struct MIDI_parked_events * parked;
+    /** Latest unread values of continuous controllers, set when
+        :c:member:`RMR_Port_config.coalesce_controllers` is set */
+    struct MIDI_coalesce_table * coalesce;
+    /** States of 16 channels updated by the input thread, set when
+        :c:member:`RMR_Port_config.track_channel_state` is set */
+    struct MIDI_state_tracker * channel_state;
+    /** Consumers receiving every message instead of an input queue, set when
+        :c:member:`RMR_Port_config.fan_out` is set */
+    struct MIDI_fan_out * fan_out;
+    /** Workers running callbacks instead of the input thread, set when
+        :c:member:`RMR_Port_config.callback_workers` is not zero */
+    struct MIDI_callback_pool * callback_pool;
     /** A GLib asynchronous que to store errors */
     GAsyncQueue * error_async_queue;
+    /** An eventfd signalled when messages or errors are published, **-1** if unavailable;
+        look at :c:func:`get_midi_input_fd` */
+    int wakeup_fd;
+    /** Set when wakeup_fd was signalled and not cleared yet, so a burst signals it once */
+    atomic_bool wakeup_pending;
+    /** Signalled by consumers after reads, the input thread waits on it
+        with :c:member:`overflow_policy_t.OP_BLOCK` */
+    MIDI_room_signal room;
     /** A :c:type:`MIDI_message` instance */
     MIDI_message message;
-    /** ? */
-    unsigned char ignore_flags;
+    /** Messages accepted by the input thread, compiled from :c:member:`RMR_Port_config.filter`,
+        look at :c:func:`set_midi_input_filter` */
+    MIDI_input_filter filter;
     /** Marks if data input thread was started */
     bool do_input;
     /** ? */
     bool first_message;
-    /** Marks if a callback is used; set by :c:func:`set_MIDI_in_callback` */
+    /** Marks if a callback is used; set by :c:func:`set_MIDI_in_callback`,
+        :c:func:`set_MIDI_in_event_callback` or :c:func:`set_MIDI_in_lending_callback` */
     bool using_callback;
     /** Current MIDI callback pointer to be called on a message */
     MIDI_callback user_callback;
+    /** A callback receiving :c:type:`MIDI_event` values; set by :c:func:`set_MIDI_in_event_callback` */
+    MIDI_event_callback user_event_callback;
+    /** A callback receiving lent message bytes; set by :c:func:`set_MIDI_in_lending_callback` */
+    MIDI_lending_callback user_lending_callback;
     /** Additional data passed to a callback, seems to always be a void pointer */
     void * user_data;
+    /** A callback receiving SysEx messages in chunks; set by :c:func:`set_MIDI_in_sysex_chunk_callback` */
+    MIDI_sysex_chunk_callback user_sysex_chunk_callback;
+    /** Additional data passed to :c:member:`MIDI_in_data.user_sysex_chunk_callback` */
+    void * sysex_user_data;
+    /** Marks if a streamed SysEx message was started and not ended yet */
+    bool streaming_sysex;
+    /** Handlers indexed by :c:type:`mf_type_t`; set by :c:func:`set_MIDI_in_typed_callback` */
+    MIDI_typed_callback typed_callbacks[MF_TYPE_COUNT];
+    /** Additional data passed to :c:member:`MIDI_in_data.typed_callbacks` */
+    void * typed_user_data[MF_TYPE_COUNT];
+    /** Marks if any typed handler is set, so events are checked for them */
+    bool using_typed_callbacks;
     /** Determines if previous message should be extended
         or a new array should be created */
     bool continue_sysex;
+    /** A sequencer client and port of the message being delivered,
+        look at :c:func:`get_midi_input_source` */
+    snd_seq_addr_t source;
+    /** A byte array used to assemble a message, keeps its memory between messages */
+    GArray * bytes;
+    /** Messages waiting to be pushed to :c:member:`MIDI_in_data.midi_async_queue` at once */
+    MIDI_message * batch[MIDI_INPUT_BATCH_SIZE];
+    /** Amount of messages in :c:member:`MIDI_in_data.batch` */
+    unsigned int batch_count;
     /** Alsa_MIDI_data instance */
     Alsa_MIDI_data * amidi_data;
 } MIDI_in_data;
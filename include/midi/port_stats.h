@@ -0,0 +1,206 @@
+#include <stdatomic.h>
+#include <stddef.h>
+
+/**
+ * Per-port counters, updated by I/O threads and read by monitoring code
+ */
+
+/**
+ * Counters of a single port.
+ *
+ * Every counter has a single writer: the input thread for input ports,
+ * a sending thread for output ports. Writers update counters with relaxed
+ * loads and stores, so no locked instruction is added to a hot path.
+ * Any thread can read them with :c:func:`snapshot_port_stats`.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_port_stats {
+    /** Messages received or sent, indexed by :c:type:`mc_type_t` */
+    atomic_ulong messages[MC_TYPE_COUNT];
+    /** Bytes received or sent, indexed by :c:type:`mc_type_t` */
+    atomic_ulong bytes[MC_TYPE_COUNT];
+    /** SysEx messages assembled from more than one Alsa event */
+    atomic_ulong sysex_reassemblies;
+    /** Alsa events that couldn't be decoded to MIDI bytes */
+    atomic_ulong decode_errors;
+    /** Kernel input overruns, each one means one or more events were lost */
+    atomic_ulong input_overruns;
+    /** Sends failed because a client output buffer or pool was full */
+    atomic_ulong output_overruns;
+    /** Events rejected by an input filter */
+    atomic_ulong filtered;
+    /** Messages dropped because an input queue was full */
+    atomic_ulong queue_drops;
+    /** Values replaced by newer ones before a consumer read them */
+    atomic_ulong coalesced;
+    /** A maximal amount of messages seen in an input queue after a publication */
+    atomic_ulong queue_depth_max;
+    /** User callback calls timed with :c:member:`RMR_Port_config.time_callbacks`,
+        callback workers add to it too, look at :c:func:`port_stats_add_shared` */
+    atomic_ulong callback_calls;
+    /** Total time spent in timed user callbacks in nanoseconds, written like callback_calls */
+    atomic_ulong callback_ns;
+} MIDI_port_stats;
+
+/**
+ * A plain copy of :c:type:`MIDI_port_stats` taken at some moment.
+ * Counters are read one by one, so they aren't consistent with each other.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_port_stats_snapshot {
+    /** Messages received or sent, indexed by :c:type:`mc_type_t` */
+    unsigned long messages[MC_TYPE_COUNT];
+    /** Bytes received or sent, indexed by :c:type:`mc_type_t` */
+    unsigned long bytes[MC_TYPE_COUNT];
+    /** SysEx messages assembled from more than one Alsa event */
+    unsigned long sysex_reassemblies;
+    /** Alsa events that couldn't be decoded to MIDI bytes */
+    unsigned long decode_errors;
+    /** Kernel input overruns */
+    unsigned long input_overruns;
+    /** Sends failed because a client output buffer or pool was full */
+    unsigned long output_overruns;
+    /** Events rejected by an input filter */
+    unsigned long filtered;
+    /** Messages dropped because an input queue was full */
+    unsigned long queue_drops;
+    /** Values replaced by newer ones before a consumer read them */
+    unsigned long coalesced;
+    /** A current amount of messages in an input queue, **0** for output ports */
+    unsigned long queue_depth;
+    /** A maximal amount of messages seen in an input queue */
+    unsigned long queue_depth_max;
+    /** Timed user callback calls */
+    unsigned long callback_calls;
+    /** Total time spent in timed user callbacks in nanoseconds */
+    unsigned long callback_ns;
+} MIDI_port_stats_snapshot;
+
+/**
+ * Sets all counters to zero. Not safe while a port is running.
+ *
+ * :param stats: a :c:type:`MIDI_port_stats` instance
+ *
+ * :since: v0.2
+ */
+void reset_port_stats(MIDI_port_stats * stats) {
+    for (int class_idx = 0; class_idx < MC_TYPE_COUNT; class_idx++) {
+        atomic_init(&stats->messages[class_idx], 0);
+        atomic_init(&stats->bytes[class_idx], 0);
+    }
+    atomic_init(&stats->sysex_reassemblies, 0);
+    atomic_init(&stats->decode_errors, 0);
+    atomic_init(&stats->input_overruns, 0);
+    atomic_init(&stats->output_overruns, 0);
+    atomic_init(&stats->filtered, 0);
+    atomic_init(&stats->queue_drops, 0);
+    atomic_init(&stats->coalesced, 0);
+    atomic_init(&stats->queue_depth_max, 0);
+    atomic_init(&stats->callback_calls, 0);
+    atomic_init(&stats->callback_ns, 0);
+}
+
+/**
+ * Adds a value to a counter. Called by a counter's only writer,
+ * so a relaxed load and store replace an atomic read-modify-write.
+ *
+ * :param counter: a counter of a :c:type:`MIDI_port_stats` instance
+ * :param value: a value to add
+ *
+ * :since: v0.2
+ */
+void port_stats_add(atomic_ulong * counter, unsigned long value) {
+    atomic_store_explicit(
+        counter,
+        atomic_load_explicit(counter, memory_order_relaxed) + value,
+        memory_order_relaxed
+    );
+}
+
+/**
+ * Adds a value to a counter written by several threads, like callback timings
+ * of the input thread and callback workers.
+ *
+ * :param counter: a counter of a :c:type:`MIDI_port_stats` instance
+ * :param value: a value to add
+ *
+ * :since: v0.2
+ */
+void port_stats_add_shared(atomic_ulong * counter, unsigned long value) {
+    atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+}
+
+/**
+ * Finds a class of a MIDI message by its status byte.
+ *
+ * :param status: a first byte of a message
+ *
+ * :returns: a :c:type:`mc_type_t` value
+ *
+ * :since: v0.2
+ */
+mc_type_t get_message_class(unsigned char status) {
+    if (status < 0xF0) return MC_CHANNEL;
+    if (status == 0xF0) return MC_SYSEX;
+    if (status >= 0xF8) return MC_REALTIME;
+    return MC_SYSTEM_COMMON;
+}
+
+/**
+ * Counts a received or sent message and its bytes by its class.
+ *
+ * :param stats: a :c:type:`MIDI_port_stats` instance
+ * :param buf: message bytes
+ * :param count: length of buf
+ *
+ * :since: v0.2
+ */
+void count_port_message(MIDI_port_stats * stats, const unsigned char * buf, long count) {
+    if (count <= 0) return;
+    mc_type_t msg_class = get_message_class(buf[0]);
+    port_stats_add(&stats->messages[msg_class], 1);
+    port_stats_add(&stats->bytes[msg_class], count);
+}
+
+/**
+ * Raises a queue depth high watermark if a new depth exceeds it.
+ *
+ * :param stats: a :c:type:`MIDI_port_stats` instance
+ * :param depth: an amount of messages in a queue
+ *
+ * :since: v0.2
+ */
+void update_port_queue_depth(MIDI_port_stats * stats, size_t depth) {
+    if (depth > atomic_load_explicit(&stats->queue_depth_max, memory_order_relaxed))
+        atomic_store_explicit(&stats->queue_depth_max, depth, memory_order_relaxed);
+}
+
+/**
+ * Copies counters to a plain structure without stopping I/O.
+ * Safe to call from any thread.
+ *
+ * :param stats: a :c:type:`MIDI_port_stats` instance
+ * :param snapshot: a :c:type:`MIDI_port_stats_snapshot` instance to fill,
+ *                  :c:member:`MIDI_port_stats_snapshot.queue_depth` is set to **0**
+ *
+ * :since: v0.2
+ */
+void snapshot_port_stats(MIDI_port_stats * stats, MIDI_port_stats_snapshot * snapshot) {
+    for (int class_idx = 0; class_idx < MC_TYPE_COUNT; class_idx++) {
+        snapshot->messages[class_idx] = atomic_load_explicit(&stats->messages[class_idx], memory_order_relaxed);
+        snapshot->bytes[class_idx] = atomic_load_explicit(&stats->bytes[class_idx], memory_order_relaxed);
+    }
+    snapshot->sysex_reassemblies = atomic_load_explicit(&stats->sysex_reassemblies, memory_order_relaxed);
+    snapshot->decode_errors = atomic_load_explicit(&stats->decode_errors, memory_order_relaxed);
+    snapshot->input_overruns = atomic_load_explicit(&stats->input_overruns, memory_order_relaxed);
+    snapshot->output_overruns = atomic_load_explicit(&stats->output_overruns, memory_order_relaxed);
+    snapshot->filtered = atomic_load_explicit(&stats->filtered, memory_order_relaxed);
+    snapshot->queue_drops = atomic_load_explicit(&stats->queue_drops, memory_order_relaxed);
+    snapshot->coalesced = atomic_load_explicit(&stats->coalesced, memory_order_relaxed);
+    snapshot->queue_depth = 0;
+    snapshot->queue_depth_max = atomic_load_explicit(&stats->queue_depth_max, memory_order_relaxed);
+    snapshot->callback_calls = atomic_load_explicit(&stats->callback_calls, memory_order_relaxed);
+    snapshot->callback_ns = atomic_load_explicit(&stats->callback_ns, memory_order_relaxed);
+}
@@ -0,0 +1,214 @@
+#include <errno.h>
+#include <sys/epoll.h>
+
+/**
+ * A single input thread serving many ports, included by midi_handling.h
+ */
+
+/** An amount of epoll events handled per reactor wakeup */
+#define REACTOR_EVENT_BATCH_SIZE 32
+
+/**
+ * An epoll loop that handles input of many threadless ports,
+ * look at :c:member:`RMR_Port_config.threadless`.
+ * Thread count and wakeups don't grow with port count.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_reactor {
+    /** An epoll instance with sequencer descriptors of all added ports */
+    int epoll_fd;
+    /** An eventfd used to interrupt a reactor thread */
+    int stop_fd;
+    /** A reactor thread, valid when :c:member:`MIDI_reactor.running` is set */
+    pthread_t thread;
+    /** Marks if a reactor thread is running */
+    atomic_bool running;
+} MIDI_reactor;
+
+/**
+ * Allocates a :c:type:`MIDI_reactor` instance and its descriptors.
+ *
+ * :param reactor: a double pointer used to allocate memory for a :c:type:`MIDI_reactor` instance
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int init_midi_reactor(MIDI_reactor ** reactor) {
+    int result = 0;
+    do {
+        * reactor = calloc(1, sizeof(MIDI_reactor));
+        if (* reactor == NULL) {
+            slog("Reactor", "Unable to allocate memory for MIDI_reactor instance.");
+            result = -1;
+            break;
+        }
+        atomic_init(&(* reactor)->running, false);
+        (* reactor)->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        (* reactor)->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+        if (
+            (* reactor)->epoll_fd < 0 || (* reactor)->stop_fd < 0 ||
+            epoll_ctl((* reactor)->epoll_fd, EPOLL_CTL_ADD, (* reactor)->stop_fd, &ev) < 0
+        ) {
+            slog("Reactor", "Unable to create reactor descriptors.");
+            if ((* reactor)->epoll_fd >= 0) close((* reactor)->epoll_fd);
+            if ((* reactor)->stop_fd >= 0) close((* reactor)->stop_fd);
+            free(* reactor);
+            * reactor = NULL;
+            result = -1;
+            break;
+        }
+    } while (0);
+    return result;
+}
+
+/**
+ * Adds sequencer descriptors of an open threadless input port to a reactor.
+ * Can be called while a reactor thread is running.
+ *
+ * :param reactor: a :c:type:`MIDI_reactor` instance
+ * :param input_data: a :c:type:`MIDI_in_data` instance of an open threadless port
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int add_reactor_input(MIDI_reactor * reactor, MIDI_in_data * input_data) {
+    int result = 0;
+    do {
+        if (!input_data->do_input || !input_data->amidi_data->threadless) {
+            slog("Reactor", "only open threadless input ports can be added.");
+            result = -1;
+            break;
+        }
+        int poll_fd_count = get_midi_input_poll_descriptors_count(input_data);
+        struct pollfd * poll_fds = (struct pollfd *) alloca(poll_fd_count * sizeof(struct pollfd));
+        poll_fd_count = get_midi_input_poll_descriptors(input_data, poll_fds, poll_fd_count);
+        for (int fd_idx = 0; fd_idx < poll_fd_count; fd_idx++) {
+            struct epoll_event ev = { .events = EPOLLIN, .data.ptr = input_data };
+            if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, poll_fds[fd_idx].fd, &ev) < 0) {
+                slog("Reactor", "error adding an input descriptor.");
+                result = -1;
+            }
+        }
+    } while (0);
+    return result;
+}
+
+/**
+ * Removes sequencer descriptors of an input port from a reactor.
+ * Stop a reactor thread first, so it doesn't handle a port being removed.
+ *
+ * :param reactor: a :c:type:`MIDI_reactor` instance
+ * :param input_data: a :c:type:`MIDI_in_data` instance added with :c:func:`add_reactor_input`
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int remove_reactor_input(MIDI_reactor * reactor, MIDI_in_data * input_data) {
+    int result = 0;
+    int poll_fd_count = get_midi_input_poll_descriptors_count(input_data);
+    struct pollfd * poll_fds = (struct pollfd *) alloca(poll_fd_count * sizeof(struct pollfd));
+    poll_fd_count = get_midi_input_poll_descriptors(input_data, poll_fds, poll_fd_count);
+    for (int fd_idx = 0; fd_idx < poll_fd_count; fd_idx++) {
+        if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, poll_fds[fd_idx].fd, NULL) < 0) result = -1;
+    }
+    return result;
+}
+
+/**
+ * Waits for input on all ports of a reactor and handles it in the calling thread.
+ * Can be used from an application's loop instead of :c:func:`start_midi_reactor`.
+ *
+ * :param reactor: a :c:type:`MIDI_reactor` instance
+ * :param timeout: a time to wait in milliseconds, **-1** waits without a limit
+ *
+ * :returns: an amount of handled events, **-1** when a reactor was stopped or on an error
+ *
+ * :since: v0.2
+ */
+int poll_midi_reactor(MIDI_reactor * reactor, int timeout) {
+    struct epoll_event ready[REACTOR_EVENT_BATCH_SIZE];
+    int event_count = 0;
+    int ready_count = epoll_wait(reactor->epoll_fd, ready, REACTOR_EVENT_BATCH_SIZE, timeout);
+    if (ready_count < 0) return errno == EINTR ? 0 : -1;
+    for (int ready_idx = 0; ready_idx < ready_count; ready_idx++) {
+        // A stop descriptor has no port attached
+        if (ready[ready_idx].data.ptr == NULL) return -1;
+        int processed = process_midi_input(ready[ready_idx].data.ptr);
+        if (processed > 0) event_count += processed;
+    }
+    return event_count;
+}
+
+/**
+ * A start routine for a reactor thread.
+ *
+ * :param ptr: a void-pointer to :c:type:`MIDI_reactor`.
+ *
+ * :since: v0.2
+ */
+static void * midi_reactor_handler(void * ptr) {
+    MIDI_reactor * reactor = ptr;
+    while (atomic_load(&reactor->running)) {
+        if (poll_midi_reactor(reactor, -1) < 0) break;
+    }
+    return 0;
+}
+
+/**
+ * Starts a reactor thread handling input of all added ports.
+ *
+ * :param reactor: a :c:type:`MIDI_reactor` instance
+ *
+ * :returns: **0** on success, **-1** on an error
+ *
+ * :since: v0.2
+ */
+int start_midi_reactor(MIDI_reactor * reactor) {
+    int result = 0;
+    if (atomic_exchange(&reactor->running, true)) return result;
+    if (pthread_create(&reactor->thread, NULL, midi_reactor_handler, reactor) != 0) {
+        atomic_store(&reactor->running, false);
+        slog("Reactor", "error starting a reactor thread.");
+        result = -1;
+    }
+    return result;
+}
+
+/**
+ * Stops a reactor thread and waits for it to finish.
+ *
+ * :param reactor: a :c:type:`MIDI_reactor` instance
+ *
+ * :since: v0.2
+ */
+void stop_midi_reactor(MIDI_reactor * reactor) {
+    uint64_t value = 1;
+    if (!atomic_exchange(&reactor->running, false)) return;
+    int res = write(reactor->stop_fd, &value, sizeof(value));
+    (void) res;
+    pthread_join(reactor->thread, NULL);
+    // Clear a stop signal, so a reactor can be started or polled again
+    res = read(reactor->stop_fd, &value, sizeof(value));
+    (void) res;
+}
+
+/**
+ * Stops a reactor thread and deallocates a :c:type:`MIDI_reactor` instance.
+ * Added ports stay open.
+ *
+ * :param reactor: a :c:type:`MIDI_reactor` instance
+ *
+ * :since: v0.2
+ */
+void free_midi_reactor(MIDI_reactor * reactor) {
+    if (reactor == NULL) return;
+    stop_midi_reactor(reactor);
+    close(reactor->epoll_fd);
+    close(reactor->stop_fd);
+    free(reactor);
+}
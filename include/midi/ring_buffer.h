@@ -0,0 +1,440 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+/**
+ * Lock-free single-producer / single-consumer ring buffer
+ */
+
+/** A cache line size used to pad producer and consumer positions */
+#define RING_BUFFER_CACHE_LINE 64
+/** Time in milliseconds a producer sleeps for room before it checks a ring again */
+#define ROOM_WAIT_TIMEOUT 1
+
+/**
+ * A bounded ring buffer of fixed-size slots.
+ *
+ * Exactly one thread may push and exactly one thread may pop.
+ * Positions grow monotonically and are masked on access, so a capacity
+ * is always a power of two. Published positions and each side's private fields
+ * live on four separate cache lines, each side keeps a cached copy of the other
+ * side's position to avoid touching a shared cache line on every call.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_ring_buffer {
+    /** Write position visible to the consumer, updated by the producer only */
+    _Alignas(RING_BUFFER_CACHE_LINE) atomic_size_t head;
+    /** Producer's write position, including items not published yet */
+    _Alignas(RING_BUFFER_CACHE_LINE) size_t head_pending;
+    /** Producer's cached copy of :c:member:`MIDI_ring_buffer.tail` */
+    size_t tail_cache;
+    /** Read position, updated by the consumer only */
+    _Alignas(RING_BUFFER_CACHE_LINE) atomic_size_t tail;
+    /** Consumer's cached copy of :c:member:`MIDI_ring_buffer.head` */
+    _Alignas(RING_BUFFER_CACHE_LINE) size_t head_cache;
+    /** Slot storage, capacity * elem_size bytes */
+    _Alignas(RING_BUFFER_CACHE_LINE) unsigned char * slots;
+    /** Amount of slots, a power of two */
+    size_t capacity;
+    /** capacity - 1, used to wrap positions */
+    size_t mask;
+    /** Size of a single slot in bytes */
+    size_t elem_size;
+    /** Set by :c:func:`ring_buffer_enable_discard`, the consumer moves
+        :c:member:`MIDI_ring_buffer.tail` with compare-and-swap */
+    bool shared_tail;
+    /** A position every slot may be written at next, set with :c:member:`MIDI_ring_buffer.shared_tail`:
+        the consumer claims a slot before it copies an item and stamps it after,
+        so the producer never rewrites a slot that is being read */
+    atomic_size_t * stamps;
+} MIDI_ring_buffer;
+
+/**
+ * Allocates a ring buffer and its slot storage.
+ *
+ * :param ring: a double pointer used to allocate memory for a :c:type:`MIDI_ring_buffer` instance
+ * :param capacity: a minimal amount of slots, rounded up to a power of two
+ * :param elem_size: a size of a single slot in bytes
+ *
+ * :returns: **0** on success, **-1** on an error or when a capacity can't be rounded up
+ *
+ * :since: v0.2
+ */
+int init_ring_buffer(MIDI_ring_buffer ** ring, size_t capacity, size_t elem_size) {
+    int result = 0;
+    size_t slot_count = 1;
+    * ring = NULL;
+    do {
+        // A larger capacity has no power of two in size_t
+        if (capacity == 0 || elem_size == 0 || capacity > ((size_t) -1 >> 1) + 1) {
+            result = -1;
+            break;
+        }
+        while (slot_count < capacity) slot_count <<= 1;
+        // Positions are padded to cache lines, so the struct itself has to be aligned
+        * ring = aligned_alloc(RING_BUFFER_CACHE_LINE, sizeof(MIDI_ring_buffer));
+        if (* ring == NULL) {
+            result = -1;
+            break;
+        }
+        (* ring)->slots = calloc(slot_count, elem_size);
+        if ((* ring)->slots == NULL) {
+            free(* ring);
+            * ring = NULL;
+            result = -1;
+            break;
+        }
+        atomic_init(&(* ring)->head, 0);
+        atomic_init(&(* ring)->tail, 0);
+        (* ring)->head_pending = 0;
+        (* ring)->tail_cache = 0;
+        (* ring)->head_cache = 0;
+        (* ring)->capacity = slot_count;
+        (* ring)->mask = slot_count - 1;
+        (* ring)->elem_size = elem_size;
+        (* ring)->shared_tail = false;
+        (* ring)->stamps = NULL;
+    } while (0);
+    return result;
+}
+
+/**
+ * Deallocates a ring buffer and its slot storage.
+ * Items still stored in slots are not touched.
+ *
+ * :param ring: a :c:type:`MIDI_ring_buffer` instance
+ *
+ * :since: v0.2
+ */
+void free_ring_buffer(MIDI_ring_buffer * ring) {
+    if (ring == NULL) return;
+    free(ring->stamps);
+    free(ring->slots);
+    free(ring);
+}
+
+/**
+ * Checks if there are no free slots left. Producer side only.
+ *
+ * :param ring: a :c:type:`MIDI_ring_buffer` instance
+ *
+ * :returns: **true** when the next push would fail
+ *
+ * :since: v0.2
+ */
+bool ring_buffer_full(MIDI_ring_buffer * ring) {
+    if (ring->head_pending - ring->tail_cache >= ring->capacity) {
+        // Refresh a cached consumer position only when the ring looks full
+        ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (ring->head_pending - ring->tail_cache >= ring->capacity) return true;
+    }
+    // A claimed slot is free only after the consumer copied its item
+    return ring->stamps != NULL && atomic_load_explicit(
+        &ring->stamps[ring->head_pending & ring->mask], memory_order_acquire
+    ) != ring->head_pending;
+}
+
+/**
+ * Marks slots of copied items as free for the producer.
+ * Used with :c:func:`ring_buffer_enable_discard` only.
+ *
+ * :param ring: a :c:type:`MIDI_ring_buffer` instance
+ * :param tail: a position of the first copied item
+ * :param count: an amount of copied items
+ *
+ * :since: v0.2
+ */
+void ring_buffer_release_slots(MIDI_ring_buffer * ring, size_t tail, size_t count) {
+    for (size_t position = tail; position != tail + count; position++)
+        atomic_store_explicit(&ring->stamps[position & ring->mask], position + ring->capacity, memory_order_release);
+}
+
+/**
+ * Copies an item into the next free slot without making it visible to the consumer.
+ * Items are published with :c:func:`ring_buffer_publish`, so a batch of items
+ * costs a single position update. Producer side only.
+ *
+ * :param ring: a :c:type:`MIDI_ring_buffer` instance
+ * :param item: a pointer to elem_size bytes to copy
+ *
+ * :returns: **true** on success, **false** when the ring is full
+ *
+ * :since: v0.2
+ */
+bool ring_buffer_push_deferred(MIDI_ring_buffer * ring, const void * item) {
+    if (ring_buffer_full(ring)) return false;
+    memcpy(ring->slots + (ring->head_pending & ring->mask) * ring->elem_size, item, ring->elem_size);
+    ring->head_pending++;
+    return true;
+}
+
+/**
+ * Makes items added by :c:func:`ring_buffer_push_deferred` visible to the consumer.
+ * Producer side only.
+ *
+ * :param ring: a :c:type:`MIDI_ring_buffer` instance
+ *
+ * :since: v0.2
+ */
+void ring_buffer_publish(MIDI_ring_buffer * ring) {
+    atomic_store_explicit(&ring->head, ring->head_pending, memory_order_release);
+}
+
+/**
+ * Copies an item into the next free slot and publishes it. Producer side only.
+ *
+ * :param ring: a :c:type:`MIDI_ring_buffer` instance
+ * :param item: a pointer to elem_size bytes to copy
+ *
+ * :returns: **true** on success, **false** when the ring is full
+ *
+ * :since: v0.2
+ */
+bool ring_buffer_push(MIDI_ring_buffer * ring, const void * item) {
+    if (!ring_buffer_push_deferred(ring, item)) return false;
+    ring_buffer_publish(ring);
+    return true;
+}
+
+/**
+ * Copies the oldest item out of a ring and frees its slot. Consumer side only.
+ *
+ * :param ring: a :c:type:`MIDI_ring_buffer` instance
+ * :param item: a pointer to elem_size bytes to fill
+ *
+ * :returns: **true** on success, **false** when the ring is empty
+ *
+ * :since: v0.2
+ */
+bool ring_buffer_pop(MIDI_ring_buffer * ring, void * item) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (ring->shared_tail) {
+        do {
+            // A producer can move a tail past a cached head
+            if ((ptrdiff_t) (ring->head_cache - tail) <= 0) {
+                ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+                if (ring->head_cache == tail) return false;
+            }
+            // A slot is claimed before a copy, a producer may discard an unclaimed item meanwhile
+        } while (!atomic_compare_exchange_weak_explicit(
+            &ring->tail, &tail, tail + 1, memory_order_acq_rel, memory_order_relaxed
+        ));
+        memcpy(item, ring->slots + (tail & ring->mask) * ring->elem_size, ring->elem_size);
+        ring_buffer_release_slots(ring, tail, 1);
+        return true;
+    }
+    if (tail == ring->head_cache) {
+        // Refresh a cached producer position only when the ring looks empty
+        ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail == ring->head_cache) return false;
+    }
+    memcpy(item, ring->slots + (tail & ring->mask) * ring->elem_size, ring->elem_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Copies up to **max** oldest items out of a ring and frees their slots
+ * with a single position update. Consumer side only.
+ *
+ * :param ring: a :c:type:`MIDI_ring_buffer` instance
+ * :param items: a pointer to max * elem_size bytes to fill
+ * :param max: a maximal amount of items to copy
+ *
+ * :returns: an amount of copied items, **0** when the ring is empty
+ *
+ * :since: v0.2
+ */
+size_t ring_buffer_pop_batch(MIDI_ring_buffer * ring, void * items, size_t max) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t count;
+    do {
+        ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+        count = ring->head_cache - tail;
+        if (count > max) count = max;
+        if (count == 0) return 0;
+        if (!ring->shared_tail) break;
+        // Slots are claimed before a copy, a producer may discard unclaimed items meanwhile
+    } while (!atomic_compare_exchange_weak_explicit(
+        &ring->tail, &tail, tail + count, memory_order_acq_rel, memory_order_relaxed
+    ));
+    // Items can wrap around the end of slot storage, copy them in two parts
+    size_t first_slot = tail & ring->mask;
+    size_t first_count = ring->capacity - first_slot;
+    if (first_count > count) first_count = count;
+    memcpy(items, ring->slots + first_slot * ring->elem_size, first_count * ring->elem_size);
+    memcpy(
+        (unsigned char *) items + first_count * ring->elem_size,
+        ring->slots,
+        (count - first_count) * ring->elem_size
+    );
+    if (ring->shared_tail) ring_buffer_release_slots(ring, tail, count);
+    else atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+    return count;
+}
+
+/**
+ * Lets the producer discard the oldest items with :c:func:`ring_buffer_discard_oldest`.
+ * The consumer then claims slots with compare-and-swap instead of a plain store
+ * and stamps every slot after a copy, so the producer doesn't rewrite it meanwhile.
+ * Called before a ring is used by other threads.
+ *
+ * :param ring: a :c:type:`MIDI_ring_buffer` instance
+ *
+ * :returns: **0** on success, **-1** when slot stamps can't be allocated
+ *
+ * :since: v0.2
+ */
+int ring_buffer_enable_discard(MIDI_ring_buffer * ring) {
+    ring->stamps = malloc(ring->capacity * sizeof(atomic_size_t));
+    if (ring->stamps == NULL) return -1;
+    for (size_t slot = 0; slot < ring->capacity; slot++) atomic_init(&ring->stamps[slot], slot);
+    ring->shared_tail = true;
+    return 0;
+}
+
+/**
+ * Removes the oldest published item, so the producer can make room in a full ring.
+ * Items pushed with :c:func:`ring_buffer_push_deferred` have to be published first.
+ * Producer side only, needs :c:func:`ring_buffer_enable_discard`.
+ *
+ * :param ring: a :c:type:`MIDI_ring_buffer` instance
+ * :param item: a pointer to elem_size bytes to fill with a removed item
+ * :param can_discard: a function checking if the oldest item may be removed, **NULL** allows any item
+ *
+ * :returns: **true** when an item was removed, **false** when the consumer took all items first
+ *           or **can_discard** refused the oldest one
+ *
+ * :since: v0.2
+ */
+bool ring_buffer_discard_oldest(MIDI_ring_buffer * ring, void * item, bool ( * can_discard ) (const void * item)) {
+    if (!ring->shared_tail) return false;
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    while (tail != head) {
+        // Only the producer writes slots, reading one the consumer reads too is safe
+        memcpy(item, ring->slots + (tail & ring->mask) * ring->elem_size, ring->elem_size);
+        // A copy is checked before a tail moves, so a checked item is the removed one
+        if (can_discard && !can_discard(item)) return false;
+        if (atomic_compare_exchange_weak_explicit(
+            &ring->tail, &tail, tail + 1, memory_order_acq_rel, memory_order_acquire
+        )) {
+            ring->tail_cache = tail + 1;
+            ring_buffer_release_slots(ring, tail, 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns an amount of stored items.
+ * The value is exact only when called from the producer or the consumer thread
+ * while the other side is idle; otherwise it is a snapshot.
+ *
+ * :param ring: a :c:type:`MIDI_ring_buffer` instance
+ *
+ * :returns: an amount of items in a ring
+ *
+ * :since: v0.2
+ */
+size_t ring_buffer_count(MIDI_ring_buffer * ring) {
+    // Load the consumer position first, so the difference can't underflow
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    return head - tail;
+}
+
+/**
+ * Lets a producer of a full queue sleep until a consumer frees a slot, instead of polling.
+ * A consumer calls :c:func:`signal_room` after reads, it writes an eventfd only while a producer waits.
+ * A consumer doesn't fence its reads, so a signal may rarely be missed;
+ * a producer then wakes after :c:data:`ROOM_WAIT_TIMEOUT` and checks a queue again.
+ *
+ * :since: v0.2
+ */
+typedef struct MIDI_room_signal {
+    /** An eventfd a consumer signals, **-1** if unavailable, a producer then sleeps for a timeout */
+    int fd;
+    /** Set while a producer waits */
+    atomic_bool waiting;
+} MIDI_room_signal;
+
+/**
+ * Prepares a :c:type:`MIDI_room_signal` instance.
+ *
+ * :param room: a :c:type:`MIDI_room_signal` instance
+ *
+ * :since: v0.2
+ */
+void init_room_signal(MIDI_room_signal * room) {
+    atomic_init(&room->waiting, false);
+    room->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+/**
+ * Closes a descriptor of a :c:type:`MIDI_room_signal` instance.
+ *
+ * :param room: a :c:type:`MIDI_room_signal` instance
+ *
+ * :since: v0.2
+ */
+void free_room_signal(MIDI_room_signal * room) {
+    if (room->fd >= 0) close(room->fd);
+    room->fd = -1;
+}
+
+/**
+ * Tells a consumer a producer is about to wait. Producer side only,
+ * a queue is checked again after this call and :c:func:`wait_for_room` gets a result.
+ *
+ * :param room: a :c:type:`MIDI_room_signal` instance
+ *
+ * :since: v0.2
+ */
+void prepare_room_wait(MIDI_room_signal * room) {
+    atomic_store(&room->waiting, true);
+    // A flag is visible before a queue is checked again
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+/**
+ * Sleeps until a consumer signals room or a timeout expires. Producer side only.
+ *
+ * :param room: a :c:type:`MIDI_room_signal` instance
+ * :param full: a result of a queue check made after :c:func:`prepare_room_wait`,
+ *              **false** returns at once
+ *
+ * :since: v0.2
+ */
+void wait_for_room(MIDI_room_signal * room, bool full) {
+    uint64_t value;
+    if (full) {
+        struct pollfd poll_fd = { .fd = room->fd, .events = POLLIN };
+        int res = poll(&poll_fd, 1, ROOM_WAIT_TIMEOUT);
+        if (res > 0) res = read(room->fd, &value, sizeof(value));
+        (void) res;
+    }
+    atomic_store(&room->waiting, false);
+}
+
+/**
+ * Wakes a waiting producer after a consumer read items. Consumer side only,
+ * costs a single load when nobody waits.
+ *
+ * :param room: a :c:type:`MIDI_room_signal` instance
+ *
+ * :since: v0.2
+ */
+void signal_room(MIDI_room_signal * room) {
+    if (!atomic_load_explicit(&room->waiting, memory_order_relaxed)) return;
+    uint64_t one = 1;
+    int res = write(room->fd, &one, sizeof(one));
+    (void) res;
+}
@@ -7,6 +7,22 @@
  */
 typedef void ( * MIDI_callback ) (double timestamp, unsigned char * buf, long count, void * user_data);
 
+/**
+ * A function definition for processing MIDI callbacks with lent bytes.
+ * **buf** points to an internal decoding buffer, it is only valid during a call
+ * and must not be freed. **time_ns** is an absolute CLOCK_MONOTONIC time in nanoseconds,
+ * or a queue tick when a port uses :c:member:`ts_mode_t.TS_TICK`.
+ */
+typedef void ( * MIDI_lending_callback ) (double timestamp, uint64_t time_ns, const unsigned char * buf, long count, void * user_data);
+
+/**
+ * A function definition for processing SysEx chunks.
+ * **buf** is only valid during a call, **flags** combine
+ * :c:data:`MIDI_SYSEX_CHUNK_START` and :c:data:`MIDI_SYSEX_CHUNK_END`,
+ * a chunk without both flags continues a message.
+ */
+typedef void ( * MIDI_sysex_chunk_callback ) (const unsigned char * buf, long count, unsigned char flags, void * user_data);
+
 /**
  * MIDI port type
  */
@@ -20,3 +36,109 @@ typedef enum {
   /** Output mode */
   MP_OUT
 } mp_type_t;
+
+/**
+ * MIDI input queue type, selects how the input thread
+ * passes messages to a consumer
+ */
+typedef enum {
+  /** GLib asynchronous queue, a default mode */
+  MQ_ASYNC_QUEUE,
+  /** Bounded lock-free single-producer / single-consumer ring buffer */
+  MQ_RING_BUFFER,
+  /** Lock-free ring buffer of :c:type:`MIDI_event` values, SysEx payloads are passed separately */
+  MQ_EVENT_RING
+} mq_type_t;
+
+/**
+ * Input timestamp mode, selects what time Alsa stamps incoming events with
+ */
+typedef enum {
+  /** No timestamps, a port doesn't use an input queue */
+  TS_NONE,
+  /** Real time of an input queue, a default mode */
+  TS_REAL_TIME,
+  /** Musical time in ticks of an input queue, based on its tempo and PPQ */
+  TS_TICK
+} ts_mode_t;
+
+/**
+ * MIDI message class, used to break down port statistics
+ */
+typedef enum {
+  /** Channel voice and mode messages, 0x80 - 0xEF */
+  MC_CHANNEL,
+  /** System common messages except SysEx, 0xF1 - 0xF7 */
+  MC_SYSTEM_COMMON,
+  /** System realtime messages, 0xF8 - 0xFF */
+  MC_REALTIME,
+  /** System exclusive messages, 0xF0 */
+  MC_SYSEX,
+  /** An amount of message classes */
+  MC_TYPE_COUNT
+} mc_type_t;
+
+/**
+ * Input queue overflow policy, selects what the input thread does
+ * when a consumer doesn't keep up and a queue is full
+ */
+typedef enum {
+  /** Drop a new message, a default mode */
+  OP_DROP_NEWEST,
+  /** Drop the oldest queued message to make room for a new one */
+  OP_DROP_OLDEST,
+  /** Wait until a consumer makes room, Alsa buffers incoming events meanwhile;
+      the input thread sleeps until a consumer reads, or for 1 ms at most */
+  OP_BLOCK,
+  /** Keep the latest value of every continuous controller until there's room,
+      drop other new messages */
+  OP_COALESCE
+} overflow_policy_t;
+
+/**
+ * MIDI message type used by input filters, look at :c:type:`MIDI_filter_config`
+ */
+typedef enum {
+  /** Note off, 0x80 */
+  MF_NOTE_OFF,
+  /** Note on, 0x90 */
+  MF_NOTE_ON,
+  /** Polyphonic key pressure, 0xA0 */
+  MF_KEY_PRESSURE,
+  /** Control change, 0xB0 */
+  MF_CONTROL_CHANGE,
+  /** Program change, 0xC0 */
+  MF_PROGRAM_CHANGE,
+  /** Channel pressure, 0xD0 */
+  MF_CHANNEL_PRESSURE,
+  /** Pitch bend, 0xE0 */
+  MF_PITCH_BEND,
+  /** System exclusive, 0xF0 */
+  MF_SYSEX,
+  /** MIDI time code quarter frame, 0xF1 */
+  MF_TIME_CODE,
+  /** Song position pointer, 0xF2 */
+  MF_SONG_POSITION,
+  /** Song select, 0xF3 */
+  MF_SONG_SELECT,
+  /** Tune request, 0xF6 */
+  MF_TUNE_REQUEST,
+  /** Timing clock, 0xF8 */
+  MF_CLOCK,
+  /** Timing tick, 0xF9 */
+  MF_TICK,
+  /** Start, 0xFA */
+  MF_START,
+  /** Continue, 0xFB */
+  MF_CONTINUE,
+  /** Stop, 0xFC */
+  MF_STOP,
+  /** Active sensing, 0xFE */
+  MF_ACTIVE_SENSING,
+  /** System reset, 0xFF */
+  MF_RESET,
+  /** Sequencer events without a MIDI message type */
+  MF_OTHER,
+  /** An amount of message types */
+  MF_TYPE_COUNT
+} mf_type_t;
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "asoundlib.h"
+// Benchmarked functions
+#include "midi/event_decoding.h"
+
+// Amount of distinct events in a test set
+#define EVENT_COUNT 1024
+// Amount of passes over a test set
+#define PASS_COUNT 2000
+
+snd_seq_event_t events[EVENT_COUNT];
+
+double elapsed_ns(struct timespec * start, struct timespec * end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+// Fill a test set with a typical mix of notes, controllers, pitch bends and clocks
+void fill_events() {
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        snd_seq_event_t * ev = &events[i];
+        memset(ev, 0, sizeof(snd_seq_event_t));
+        switch (i % 8) {
+        case 0:
+        case 1:
+            ev->type = SND_SEQ_EVENT_NOTEON;
+            ev->data.note.channel = i % 16;
+            ev->data.note.note = i % 128;
+            ev->data.note.velocity = 1 + i % 127;
+            break;
+        case 2:
+        case 3:
+            ev->type = SND_SEQ_EVENT_NOTEOFF;
+            ev->data.note.channel = i % 16;
+            ev->data.note.note = i % 128;
+            break;
+        case 4:
+            ev->type = SND_SEQ_EVENT_CONTROLLER;
+            ev->data.control.channel = i % 16;
+            ev->data.control.param = i % 120;
+            ev->data.control.value = i % 128;
+            break;
+        case 5:
+            ev->type = SND_SEQ_EVENT_PITCHBEND;
+            ev->data.control.channel = i % 16;
+            ev->data.control.value = (i * 37) % 16384 - 8192;
+            break;
+        default:
+            ev->type = SND_SEQ_EVENT_CLOCK;
+        }
+    }
+}
+
+int main() {
+    snd_midi_event_t * coder;
+    unsigned char buffer[32];
+    unsigned char fast_buffer[32];
+    struct timespec start, end;
+    unsigned long checksum = 0;
+    bool equal = true;
+
+    fill_events();
+    if (snd_midi_event_new(0, &coder) < 0) {
+        printf("Error initializing MIDI event parser\n");
+        return 1;
+    }
+    snd_midi_event_init(coder);
+    snd_midi_event_no_status(coder, 1);
+
+    // Both decoders have to produce the same bytes
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        long count = snd_midi_event_decode(coder, buffer, sizeof(buffer), &events[i]);
+        long fast_count = decode_alsa_event_fast(&events[i], fast_buffer);
+        if (count != fast_count || memcmp(buffer, fast_buffer, count) != 0) equal = false;
+    }
+    printf("Equal output: %d\n", equal);
+
+    // Generic Alsa decoder
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int pass = 0; pass < PASS_COUNT; pass++) {
+        for (int i = 0; i < EVENT_COUNT; i++) {
+            checksum += snd_midi_event_decode(coder, buffer, sizeof(buffer), &events[i]) + buffer[0];
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double generic_ns = elapsed_ns(&start, &end) / ((double) PASS_COUNT * EVENT_COUNT);
+
+    // Table-driven fast path
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int pass = 0; pass < PASS_COUNT; pass++) {
+        for (int i = 0; i < EVENT_COUNT; i++) {
+            checksum += decode_alsa_event_fast(&events[i], fast_buffer) + fast_buffer[0];
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double fast_ns = elapsed_ns(&start, &end) / ((double) PASS_COUNT * EVENT_COUNT);
+
+    printf("snd_midi_event_decode: %.2f ns/event\n", generic_ns);
+    printf("decode_alsa_event_fast: %.2f ns/event\n", fast_ns);
+    printf("Speedup: %.1fx\n", generic_ns / fast_ns);
+    // Keep the loops from being optimized out
+    printf("Checksum: %lu\n", checksum);
+
+    snd_midi_event_free(coder);
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "midi/midi_handling.h"
+
+#define MESSAGE_COUNT 200
+
+atomic_int received;
+atomic_int broken;
+
+// A slow consumer, so a short worker queue keeps filling up
+void count_event(MIDI_event event, const unsigned char * sysex, void * user_data) {
+    long count = event.sysex_count;
+    if (sysex == NULL || sysex[0] != 0xF0 || sysex[count - 1] != 0xF7 || sysex[1] != count % 0x80)
+        atomic_fetch_add(&broken, 1);
+    atomic_fetch_add(&received, 1);
+    g_usleep(50);
+}
+
+// Never set, callback kinds exclude each other
+void lend_bytes(double timestamp, uint64_t time_ns, const unsigned char * buf, long count, void * user_data) {
+    atomic_fetch_add(&broken, 1);
+}
+
+int main() {
+    RMR_Port_config * port_config;
+    MIDI_in_data * input_data;
+    Alsa_MIDI_data * amidi_data = calloc(1, sizeof(Alsa_MIDI_data));
+    static unsigned char sysex[CALLBACK_SYSEX_BUFFER_SIZE * 2];
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    port_config->callback_workers = 1;
+    port_config->callback_queue_size = 4;
+    port_config->overflow_policy = OP_BLOCK;
+    port_config->threadless = true;
+    prepare_input_data(&input_data, port_config);
+    amidi_data->timestamp_mode = TS_REAL_TIME;
+    amidi_data->threadless = true;
+    amidi_data->time_callbacks = true;
+    assign_midi_data(input_data, amidi_data);
+    set_MIDI_in_event_callback(input_data, count_event, NULL);
+    bool exclusive = set_MIDI_in_lending_callback(input_data, lend_bytes, NULL) == -1;
+    start_callback_pool(input_data->callback_pool, run_callback_job, input_data);
+    input_data->do_input = true;
+
+    // Short messages use preallocated buffers, every tenth one is longer than a buffer
+    for (int msg_idx = 0; msg_idx < MESSAGE_COUNT; msg_idx++) {
+        long count = msg_idx % 10 == 0 ? sizeof(sysex) : 16 + msg_idx % 64;
+        memset(sysex, 0x01, count);
+        sysex[0] = 0xF0;
+        sysex[1] = count % 0x80;
+        sysex[count - 1] = 0xF7;
+        hand_off_callback(input_data, sysex, count, 0.0, msg_idx);
+        publish_callback_jobs(input_data->callback_pool);
+    }
+    stop_callback_pool(input_data->callback_pool);
+
+    MIDI_port_stats_snapshot snapshot;
+    get_midi_port_stats(amidi_data, input_data, &snapshot);
+    printf("Received: %d, broken: %d\n", atomic_load(&received), atomic_load(&broken));
+    printf("Dropped: %lu, timed calls: %lu\n", snapshot.queue_drops, snapshot.callback_calls);
+    printf("Second callback rejected: %d\n", exclusive);
+    bool result = exclusive && atomic_load(&received) == MESSAGE_COUNT && atomic_load(&broken) == 0 &&
+        snapshot.queue_drops == 0 && snapshot.callback_calls == MESSAGE_COUNT;
+    destroy_input_data(input_data);
+    destroy_port_config(port_config);
+    free(amidi_data);
+    printf("Callback pool: %s\n", result ? "ok" : "failed");
+    return result ? 0 : 1;
+}
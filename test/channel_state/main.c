@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "asoundlib.h"
+// Tested functions
+#include "midi/channel_state.h"
+
+#define WRITES 200000
+
+MIDI_state_tracker * tracker;
+atomic_bool writing;
+
+void send_event(int type, int channel, int param, int value) {
+    snd_seq_event_t ev;
+    memset(&ev, 0, sizeof(snd_seq_event_t));
+    ev.type = type;
+    if (type == SND_SEQ_EVENT_NOTEON || type == SND_SEQ_EVENT_NOTEOFF) {
+        ev.data.note.channel = channel;
+        ev.data.note.note = param;
+        ev.data.note.velocity = value;
+    } else {
+        ev.data.control.channel = channel;
+        ev.data.control.param = param;
+        ev.data.control.value = value;
+    }
+    update_state_tracker(tracker, &ev);
+}
+
+bool is_held(MIDI_channel_state * state, int note) {
+    return (state->notes[note >> 6] >> (note & 63)) & 1;
+}
+
+void * write_channel(void * arg) {
+    (void) arg;
+    MIDI_channel_slot * slot = &tracker->channels[9];
+    // Every update sets all controllers to one value, a torn copy would mix them
+    for (int write_idx = 0; write_idx < WRITES; write_idx++) {
+        begin_channel_update(slot);
+        memset(slot->state.controllers, write_idx & 0x7F, sizeof(slot->state.controllers));
+        end_channel_update(slot);
+        // Lets a reader run on a single CPU too
+        if ((write_idx & 255) == 0) sched_yield();
+    }
+    atomic_store(&writing, false);
+    return NULL;
+}
+
+int main() {
+    MIDI_channel_state state;
+    if (init_state_tracker(&tracker) != 0) {
+        printf("Unable to allocate a tracker\n");
+        return 1;
+    }
+
+    send_event(SND_SEQ_EVENT_NOTEON, 2, 60, 100);
+    send_event(SND_SEQ_EVENT_NOTEON, 2, 100, 90);
+    send_event(SND_SEQ_EVENT_NOTEON, 2, 64, 0);
+    send_event(SND_SEQ_EVENT_CONTROLLER, 2, 7, 99);
+    send_event(SND_SEQ_EVENT_CONTROL14, 2, 1, 0x1234);
+    send_event(SND_SEQ_EVENT_PGMCHANGE, 2, 0, 42);
+    send_event(SND_SEQ_EVENT_PITCHBEND, 2, 0, -4000);
+    send_event(SND_SEQ_EVENT_CHANPRESS, 2, 0, 33);
+    read_channel_state(tracker, 2, &state);
+    printf("Held notes 60, 100, 64: %d %d %d\n", is_held(&state, 60), is_held(&state, 100), is_held(&state, 64));
+    printf("Volume: %d, modulation MSB and LSB: %d %d\n", state.controllers[7], state.controllers[1], state.controllers[33]);
+    printf("Program: %d, pitch bend: %d, pressure: %d\n", state.program, state.pitch_bend, state.channel_pressure);
+
+    read_channel_state(tracker, 3, &state);
+    printf("Other channel untouched: %d\n", state.controllers[7] == 0 && state.notes[0] == 0 && state.notes[1] == 0);
+
+    send_event(SND_SEQ_EVENT_NOTEOFF, 2, 60, 0);
+    send_event(SND_SEQ_EVENT_CONTROLLER, 2, 64, 127);
+    send_event(SND_SEQ_EVENT_CONTROLLER, 2, 121, 0);
+    read_channel_state(tracker, 2, &state);
+    printf("Note 60 after note off: %d\n", is_held(&state, 60));
+    printf("After reset: sustain %d, expression %d, volume %d, pitch bend %d\n",
+        state.controllers[64], state.controllers[11], state.controllers[7], state.pitch_bend);
+
+    send_event(SND_SEQ_EVENT_CONTROLLER, 2, 123, 0);
+    read_channel_state(tracker, 2, &state);
+    printf("Note 100 after all notes off: %d\n", is_held(&state, 100));
+
+    // Copies made while a writer keeps changing a channel are never torn
+    pthread_t writer;
+    atomic_store(&writing, true);
+    pthread_create(&writer, NULL, write_channel, NULL);
+    unsigned long reads = 0, torn = 0;
+    while (atomic_load(&writing)) {
+        read_channel_state(tracker, 9, &state);
+        for (int controller = 1; controller < 128; controller++) {
+            if (state.controllers[controller] != state.controllers[0]) {
+                torn++;
+                break;
+            }
+        }
+        reads++;
+    }
+    pthread_join(writer, NULL);
+    printf("Torn copies: %lu\n", torn);
+    printf("Reads done: %d\n", reads > 0);
+
+    free_state_tracker(tracker);
+    return torn > 0;
+}
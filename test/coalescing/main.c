@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include "midi/midi_handling.h"
+
+// A 14-bit modulation controller decodes to two control changes
+unsigned char control14[] = { 0xB0, 0x01, 0x10, 0xB0, 0x21, 0x05 };
+
+// Reads every queued event, returns a value of the last modulation control change
+int read_modulation(MIDI_in_data * input_data, int * long_events) {
+    MIDI_event event;
+    MIDI_message * sysex;
+    int value = -1;
+    while (pop_midi_event(input_data, &event)) {
+        if (event.flags & MIDI_EVENT_PAYLOAD) {
+            // A long message isn't a SysEx message
+            if (event.flags == MIDI_EVENT_LONG) (* long_events)++;
+            sysex = pop_midi_sysex(input_data);
+            // A long message keeps its own bytes, including an LSB value
+            if (sysex == NULL || sysex->count != 6 || sysex->buf[5] != 0x05) printf("Broken 14-bit payload\n");
+            if (sysex) free_midi_message(sysex);
+        } else if (event.bytes[0] == 0xB0 && event.bytes[1] == 0x01) {
+            value = event.bytes[2];
+        }
+    }
+    return value;
+}
+
+bool check_queue_type(mq_type_t queue_type) {
+    RMR_Port_config * port_config;
+    MIDI_in_data * input_data;
+    Alsa_MIDI_data * amidi_data = calloc(1, sizeof(Alsa_MIDI_data));
+    int long_events = 0;
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    port_config->queue_type = queue_type;
+    port_config->coalesce_controllers = true;
+    port_config->threadless = true;
+    prepare_input_data(&input_data, port_config);
+    // Messages are queued directly, no sequencer is needed
+    amidi_data->timestamp_mode = TS_REAL_TIME;
+    amidi_data->threadless = true;
+    assign_midi_data(input_data, amidi_data);
+
+    queue_input_message(input_data, control14, sizeof(control14), 0.0, 1, 0);
+    // Ordinary values of the same controller are coalesced to the latest one
+    for (unsigned char value = 1; value <= 5; value++) {
+        unsigned char cc[] = { 0xB0, 0x01, value };
+        queue_input_message(input_data, cc, sizeof(cc), 0.0, 1 + value, 0);
+    }
+    flush_input_batch(input_data);
+    int first = read_modulation(input_data, &long_events);
+
+    // A slot is free again after a read
+    unsigned char cc[] = { 0xB0, 0x01, 100 };
+    queue_input_message(input_data, cc, sizeof(cc), 0.0, 10, 0);
+    flush_input_batch(input_data);
+    int second = read_modulation(input_data, &long_events);
+
+    printf("14-bit events: %d, latest values: %d %d\n", long_events, first, second);
+    destroy_input_data(input_data);
+    destroy_port_config(port_config);
+    free(amidi_data);
+    return long_events == 1 && first == 5 && second == 100;
+}
+
+bool check_drop_oldest(mq_type_t queue_type) {
+    RMR_Port_config * port_config;
+    MIDI_in_data * input_data;
+    Alsa_MIDI_data * amidi_data = calloc(1, sizeof(Alsa_MIDI_data));
+    int long_events = 0;
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    port_config->queue_type = queue_type;
+    port_config->ring_size = 4;
+    port_config->queue_capacity = 4;
+    port_config->overflow_policy = OP_DROP_OLDEST;
+    port_config->coalesce_controllers = true;
+    port_config->threadless = true;
+    prepare_input_data(&input_data, port_config);
+    amidi_data->timestamp_mode = TS_REAL_TIME;
+    amidi_data->threadless = true;
+    assign_midi_data(input_data, amidi_data);
+
+    // The oldest message carries a modulation value, notes fill the rest of a queue
+    unsigned char cc[] = { 0xB0, 0x01, 1 };
+    queue_input_message(input_data, cc, sizeof(cc), 0.0, 1, 0);
+    for (unsigned char note = 60; note < 63; note++) {
+        unsigned char note_on[] = { 0x90, note, 100 };
+        queue_input_message(input_data, note_on, sizeof(note_on), 0.0, note, 0);
+    }
+    flush_input_batch(input_data);
+    // A newer value waits in a slot, a new note drops the oldest note instead of a carrier
+    cc[2] = 2;
+    queue_input_message(input_data, cc, sizeof(cc), 0.0, 70, 0);
+    unsigned char note_on[] = { 0x90, 63, 100 };
+    queue_input_message(input_data, note_on, sizeof(note_on), 0.0, 71, 0);
+    flush_input_batch(input_data);
+    int value = read_modulation(input_data, &long_events);
+
+    printf("Latest value after a drop: %d\n", value);
+    destroy_input_data(input_data);
+    destroy_port_config(port_config);
+    free(amidi_data);
+    return value == 2;
+}
+
+bool check_tick_payload() {
+    RMR_Port_config * port_config;
+    MIDI_in_data * input_data;
+    Alsa_MIDI_data * amidi_data = calloc(1, sizeof(Alsa_MIDI_data));
+    MIDI_event event;
+    MIDI_message * payload = NULL;
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    port_config->queue_type = MQ_EVENT_RING;
+    port_config->threadless = true;
+    prepare_input_data(&input_data, port_config);
+    amidi_data->timestamp_mode = TS_TICK;
+    amidi_data->threadless = true;
+    assign_midi_data(input_data, amidi_data);
+
+    // An event carries a tick, a payload keeps its time and tick apart
+    queue_input_message(input_data, control14, sizeof(control14), 0.0, 5000, 7);
+    flush_input_batch(input_data);
+    bool read = pop_midi_event(input_data, &event);
+    if (read) payload = pop_midi_sysex(input_data);
+    bool result = read && event.tick == 7 && payload != NULL && payload->tick == 7 && payload->time_ns == 5000;
+
+    printf("Tick of a long event: %s\n", result ? "kept" : "broken");
+    if (payload) free_midi_message(payload);
+    destroy_input_data(input_data);
+    destroy_port_config(port_config);
+    free(amidi_data);
+    return result;
+}
+
+bool check_sysex_head() {
+    RMR_Port_config * port_config;
+    MIDI_in_data * input_data;
+    Alsa_MIDI_data * amidi_data = calloc(1, sizeof(Alsa_MIDI_data));
+    MIDI_event event;
+    MIDI_message * sysex;
+    int notes = 0;
+    int last_note = -1;
+    bool sysex_first = false;
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    port_config->queue_type = MQ_EVENT_RING;
+    port_config->ring_size = 4;
+    port_config->overflow_policy = OP_DROP_OLDEST;
+    port_config->threadless = true;
+    prepare_input_data(&input_data, port_config);
+    amidi_data->timestamp_mode = TS_REAL_TIME;
+    amidi_data->threadless = true;
+    assign_midi_data(input_data, amidi_data);
+
+    // A SysEx event at the head of a full ring can't be dropped, its payload may be read already
+    unsigned char sysex_bytes[] = { 0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7 };
+    queue_input_message(input_data, sysex_bytes, sizeof(sysex_bytes), 0.0, 1, 0);
+    for (unsigned char note = 60; note < 64; note++) {
+        unsigned char note_on[] = { 0x90, note, 100 };
+        queue_input_message(input_data, note_on, sizeof(note_on), 0.0, note, 0);
+    }
+    flush_input_batch(input_data);
+    while (pop_midi_event(input_data, &event)) {
+        if (event.flags & MIDI_EVENT_SYSEX) {
+            sysex_first = notes == 0;
+            sysex = pop_midi_sysex(input_data);
+            if (sysex) free_midi_message(sysex);
+        } else {
+            notes++;
+            last_note = event.bytes[1];
+        }
+    }
+    unsigned long drops = atomic_load(&amidi_data->stats.queue_drops);
+
+    printf("SysEx kept: %d, notes: %d, last note: %d, drops: %lu\n", sysex_first, notes, last_note, drops);
+    destroy_input_data(input_data);
+    destroy_port_config(port_config);
+    free(amidi_data);
+    // The newest note is dropped instead
+    return sysex_first && notes == 3 && last_note == 62 && drops == 1;
+}
+
+int main() {
+    bool event_ring = check_queue_type(MQ_EVENT_RING) && check_drop_oldest(MQ_EVENT_RING) && check_sysex_head() &&
+        check_tick_payload();
+    bool message_ring = check_queue_type(MQ_RING_BUFFER) && check_drop_oldest(MQ_RING_BUFFER);
+    bool async_queue = check_drop_oldest(MQ_ASYNC_QUEUE);
+    printf("Event ring: %s\n", event_ring ? "ok" : "failed");
+    printf("Message ring: %s\n", message_ring ? "ok" : "failed");
+    printf("Async queue: %s\n", async_queue ? "ok" : "failed");
+    return event_ring && message_ring && async_queue ? 0 : 1;
+}
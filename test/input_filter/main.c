@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "asoundlib.h"
+#include "midi/typedefs.h"
+#include "midi/event_decoding.h"
+// Tested functions
+#include "midi/input_filter.h"
+
+MIDI_filter_config config;
+MIDI_input_filter filter;
+
+snd_seq_event_t make_event(int type, int channel, int param, int client) {
+    snd_seq_event_t ev;
+    memset(&ev, 0, sizeof(snd_seq_event_t));
+    ev.type = type;
+    ev.source.client = client;
+    if (type == SND_SEQ_EVENT_CONTROLLER) {
+        ev.data.control.channel = channel;
+        ev.data.control.param = param;
+    } else {
+        ev.data.note.channel = channel;
+        ev.data.note.note = param;
+    }
+    return ev;
+}
+
+bool accepts(int type, int channel, int param, int client) {
+    snd_seq_event_t ev = make_event(type, channel, param, client);
+    return accept_alsa_event(&filter, &ev);
+}
+
+int main() {
+    // A default configuration accepts everything and skips checks
+    reset_midi_filter_config(&config);
+    compile_midi_filter(&filter, &config);
+    printf("Default filter active: %d\n", filter.active);
+    printf("Default accepts SysEx: %d\n", accepts(SND_SEQ_EVENT_SYSEX, 0, 0, 20));
+
+    // Same as RtMidi's default ignoreTypes
+    ignore_midi_types(&config, true, true, true);
+    compile_midi_filter(&filter, &config);
+    printf("Ignored SysEx: %d\n", !accepts(SND_SEQ_EVENT_SYSEX, 0, 0, 20));
+    printf("Ignored clock: %d\n", !accepts(SND_SEQ_EVENT_CLOCK, 0, 0, 20));
+    printf("Ignored sensing: %d\n", !accepts(SND_SEQ_EVENT_SENSING, 0, 0, 20));
+    printf("Accepted start: %d\n", accepts(SND_SEQ_EVENT_START, 0, 0, 20));
+
+    // Notes of channel 1 only, in a keyboard split range
+    reset_midi_filter_config(&config);
+    config.channels[MF_NOTE_ON] = config.channels[MF_NOTE_OFF] = 0x0001;
+    config.note_min = 36;
+    config.note_max = 59;
+    compile_midi_filter(&filter, &config);
+    printf("Accepted note in range: %d\n", accepts(SND_SEQ_EVENT_NOTEON, 0, 48, 20));
+    printf("Rejected note above range: %d\n", !accepts(SND_SEQ_EVENT_NOTEON, 0, 60, 20));
+    printf("Rejected note on channel 2: %d\n", !accepts(SND_SEQ_EVENT_NOTEOFF, 1, 48, 20));
+    printf("Accepted controller on channel 2: %d\n", accepts(SND_SEQ_EVENT_CONTROLLER, 1, 7, 20));
+
+    // Modulation and volume from a single sender
+    reset_midi_filter_config(&config);
+    config.types = 1u << MF_CONTROL_CHANGE;
+    config.controller_min = 1;
+    config.controller_max = 7;
+    add_midi_filter_source(&config, 24, 0);
+    compile_midi_filter(&filter, &config);
+    printf("Accepted controller: %d\n", accepts(SND_SEQ_EVENT_CONTROLLER, 5, 7, 24));
+    printf("Rejected controller out of range: %d\n", !accepts(SND_SEQ_EVENT_CONTROLLER, 5, 64, 24));
+    printf("Rejected other sender: %d\n", !accepts(SND_SEQ_EVENT_CONTROLLER, 5, 7, 20));
+    printf("Rejected note: %d\n", !accepts(SND_SEQ_EVENT_NOTEON, 5, 60, 24));
+
+    // Zeroed filters accept everything
+    memset(&filter, 0, sizeof(MIDI_input_filter));
+    printf("Zeroed accepts note: %d\n", accepts(SND_SEQ_EVENT_NOTEON, 3, 60, 20));
+
+    return 0;
+}
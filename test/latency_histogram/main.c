@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+// Tested functions
+#include "midi/latency_histogram.h"
+
+// Amount of values recorded by each thread
+#define VALUE_COUNT 100000
+
+MIDI_latency_histogram * histogram;
+
+void * recorder(void * ptr) {
+    // Values from 1 us to 100 ms
+    for (uint64_t i = 1; i <= VALUE_COUNT; i++) record_latency(histogram, i * 1000);
+    return NULL;
+}
+
+int main() {
+    pthread_t threads[2];
+    bool continuous = true;
+
+    // Every value falls into a bucket starting at or below it
+    for (uint64_t value = 0; value < 100000; value++) {
+        unsigned int bucket = get_latency_bucket(value);
+        if (get_latency_bucket_floor(bucket) > value) continuous = false;
+        if (get_latency_bucket_floor(bucket + 1) <= value) continuous = false;
+    }
+    printf("Buckets continuous: %d\n", continuous);
+    printf("Last bucket: %u of %d\n", get_latency_bucket(UINT64_MAX), LATENCY_BUCKET_COUNT);
+
+    init_latency_histogram(&histogram);
+    printf("Empty p99: %llu\n", (unsigned long long) get_latency_percentile(histogram, 99.0));
+
+    // Records from many threads are not lost
+    for (int i = 0; i < 2; i++) pthread_create(&threads[i], NULL, recorder, NULL);
+    for (int i = 0; i < 2; i++) pthread_join(threads[i], NULL);
+
+    printf("Count: %lu\n", get_latency_count(histogram));
+    printf("Max: %llu ns\n", (unsigned long long) get_latency_max(histogram));
+    printf("Mean: %llu ns\n", (unsigned long long) get_latency_mean(histogram));
+    // Exact values are 50 ms, 90 ms and 99 ms, buckets are up to 12.5% wide
+    printf("p50: %llu ns\n", (unsigned long long) get_latency_percentile(histogram, 50.0));
+    printf("p90: %llu ns\n", (unsigned long long) get_latency_percentile(histogram, 90.0));
+    printf("p99: %llu ns\n", (unsigned long long) get_latency_percentile(histogram, 99.0));
+    printf("p100: %llu ns\n", (unsigned long long) get_latency_percentile(histogram, 100.0));
+
+    reset_latency_histogram(histogram);
+    printf("Count after reset: %lu\n", get_latency_count(histogram));
+
+    free_latency_histogram(histogram);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include "midi/midi_handling.h"
+
+// Amount of messages every returning thread frees
+#define MESSAGE_COUNT 200000
+// Amount of threads freeing messages at once
+#define THREAD_COUNT 4
+// Amount of preallocated messages, a few stay with every returning thread
+#define POOL_SIZE 16
+
+MIDI_message_pool * pool;
+// Messages passed from the input thread to every returning thread
+MIDI_ring_buffer * handed[THREAD_COUNT];
+atomic_int broken;
+
+// A consumer freeing messages of its own ring, other consumers free theirs at the same time
+void * return_messages(void * ptr) {
+    MIDI_ring_buffer * ring = ptr;
+    MIDI_message * message;
+    int received = 0;
+    while (received < MESSAGE_COUNT) {
+        if (!ring_buffer_pop(ring, &message)) {
+            sched_yield();
+            continue;
+        }
+        if (message->buf[0] != 0x90 || message->buf[1] != received % 0x80) atomic_fetch_add(&broken, 1);
+        free_midi_message(message);
+        received++;
+    }
+    return NULL;
+}
+
+int main() {
+    pthread_t threads[THREAD_COUNT];
+    int sent[THREAD_COUNT] = { 0 };
+    int total = 0;
+    bool taken_twice = false;
+    init_message_pool(&pool, POOL_SIZE, 3);
+    for (int thread_idx = 0; thread_idx < THREAD_COUNT; thread_idx++) {
+        init_ring_buffer(&handed[thread_idx], POOL_SIZE, sizeof(MIDI_message *));
+        pthread_create(&threads[thread_idx], NULL, return_messages, handed[thread_idx]);
+    }
+
+    // The input thread side takes messages as soon as they are returned
+    while (total < MESSAGE_COUNT * THREAD_COUNT) {
+        int thread_idx = total % THREAD_COUNT;
+        MIDI_message * message = take_pooled_message(pool, 3);
+        if (message == NULL) {
+            sched_yield();
+            continue;
+        }
+        message->buf[0] = 0x90;
+        message->buf[1] = sent[thread_idx] % 0x80;
+        while (!ring_buffer_push(handed[thread_idx], &message)) sched_yield();
+        sent[thread_idx]++;
+        total++;
+    }
+    for (int thread_idx = 0; thread_idx < THREAD_COUNT; thread_idx++) pthread_join(threads[thread_idx], NULL);
+
+    // Every message is back exactly once
+    MIDI_message * messages[POOL_SIZE];
+    size_t count = 0;
+    while (count < POOL_SIZE && (messages[count] = take_pooled_message(pool, 3)) != NULL) count++;
+    for (size_t msg_idx = 0; msg_idx < count; msg_idx++)
+        for (size_t other_idx = msg_idx + 1; other_idx < count; other_idx++)
+            if (messages[msg_idx] == messages[other_idx]) taken_twice = true;
+    bool empty = take_pooled_message(pool, 3) == NULL;
+
+    printf("Broken: %d, messages back: %zu, taken twice: %d\n", atomic_load(&broken), count, taken_twice);
+    bool result = atomic_load(&broken) == 0 && count == POOL_SIZE && !taken_twice && empty;
+    for (int thread_idx = 0; thread_idx < THREAD_COUNT; thread_idx++) free_ring_buffer(handed[thread_idx]);
+    free_message_pool(pool);
+    printf("Message pool: %s\n", result ? "ok" : "failed");
+    return result ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include "midi/midi_handling.h"
+
+unsigned char clock_tick[] = { 0xF8 };
+// A 14-bit controller is a long channel message, its payload isn't a SysEx lane message
+unsigned char control14[] = { 0xB0, 0x01, 0x10, 0xB0, 0x21, 0x05 };
+unsigned char volume[] = { 0xB0, 0x07, 0x64 };
+unsigned char sysex[] = { 0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7 };
+unsigned char pan[] = { 0xB0, 0x0A, 0x40 };
+
+// Realtime messages go first, SysEx messages go last, the rest keeps arrival order
+unsigned char expected[] = { 0xF8, 0xB0, 0xB0, 0xB0, 0xF0 };
+
+void queue_messages(MIDI_in_data * input_data) {
+    queue_input_message(input_data, control14, sizeof(control14), 0.0, 1, 0);
+    queue_input_message(input_data, sysex, sizeof(sysex), 0.0, 2, 0);
+    queue_input_message(input_data, volume, sizeof(volume), 0.0, 3, 0);
+    queue_input_message(input_data, clock_tick, sizeof(clock_tick), 0.0, 4, 0);
+    queue_input_message(input_data, pan, sizeof(pan), 0.0, 5, 0);
+    flush_input_batch(input_data);
+}
+
+// Checks an event against an expected one, a payload is read for long events
+bool check_event(MIDI_in_data * input_data, MIDI_event * event, int event_idx) {
+    bool result = event_idx < (int) sizeof(expected);
+    if (event->flags & MIDI_EVENT_PAYLOAD) {
+        // Long events only have a length inline, bytes are in a payload
+        MIDI_message * payload = pop_midi_sysex(input_data);
+        if (payload == NULL) return false;
+        unsigned char * bytes = event_idx == 1 ? control14 : sysex;
+        result = result && event->flags == (event_idx == 1 ? MIDI_EVENT_LONG : MIDI_EVENT_SYSEX);
+        result = result && payload->count == 6 && payload->buf[0] == expected[event_idx] &&
+            memcmp(payload->buf, bytes, 6) == 0;
+        free_midi_message(payload);
+    } else {
+        // A 14-bit controller must come with its payload
+        result = result && event_idx != 1 && event->bytes[0] == expected[event_idx];
+    }
+    return result;
+}
+
+bool check_reads(bool batch) {
+    RMR_Port_config * port_config;
+    MIDI_in_data * input_data;
+    MIDI_event events[16];
+    Alsa_MIDI_data * amidi_data = calloc(1, sizeof(Alsa_MIDI_data));
+    int event_count = 0;
+    bool result = true;
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    port_config->queue_type = MQ_EVENT_RING;
+    port_config->priority_lanes = true;
+    port_config->threadless = true;
+    prepare_input_data(&input_data, port_config);
+    // Messages are queued directly, no sequencer is needed
+    amidi_data->timestamp_mode = TS_REAL_TIME;
+    amidi_data->threadless = true;
+    assign_midi_data(input_data, amidi_data);
+
+    queue_messages(input_data);
+    if (batch) {
+        size_t count;
+        // A batch stops before a SysEx event while long messages have payloads to read
+        while ((count = pop_midi_event_batch(input_data, events, 16, 0)) > 0) {
+            for (size_t event_idx = 0; event_idx < count; event_idx++)
+                result = check_event(input_data, &events[event_idx], event_count++) && result;
+        }
+    } else {
+        while (pop_midi_event(input_data, &events[0]))
+            result = check_event(input_data, &events[0], event_count++) && result;
+    }
+
+    printf("%s: %d events read\n", batch ? "Batch" : "Single", event_count);
+    destroy_input_data(input_data);
+    destroy_port_config(port_config);
+    free(amidi_data);
+    return result && event_count == (int) sizeof(expected);
+}
+
+// Message reads don't apply to event rings, a realtime event stays for an event read
+bool check_message_read() {
+    RMR_Port_config * port_config;
+    MIDI_in_data * input_data;
+    MIDI_event event;
+    Alsa_MIDI_data * amidi_data = calloc(1, sizeof(Alsa_MIDI_data));
+    setup_port_config(&port_config, MP_VIRTUAL_IN);
+    port_config->queue_type = MQ_EVENT_RING;
+    port_config->priority_lanes = true;
+    port_config->threadless = true;
+    prepare_input_data(&input_data, port_config);
+    amidi_data->timestamp_mode = TS_REAL_TIME;
+    amidi_data->threadless = true;
+    assign_midi_data(input_data, amidi_data);
+
+    queue_input_message(input_data, clock_tick, sizeof(clock_tick), 0.0, 1, 0);
+    flush_input_batch(input_data);
+    MIDI_message * message = pop_midi_message(input_data);
+    bool result = message == NULL && pop_midi_event(input_data, &event) && event.bytes[0] == 0xF8;
+    if (message) free_midi_message(message);
+
+    destroy_input_data(input_data);
+    destroy_port_config(port_config);
+    free(amidi_data);
+    return result;
+}
+
+int main() {
+    bool single = check_reads(false);
+    bool batch = check_reads(true);
+    bool message_read = check_message_read();
+    printf("Single reads: %s\n", single ? "ok" : "failed");
+    printf("Batch reads: %s\n", batch ? "ok" : "failed");
+    printf("Message read of an event ring: %s\n", message_read ? "ok" : "failed");
+    return single && batch && message_read ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+// Tested functions
+#include "midi/ring_buffer.h"
+
+// Amount of items passed from a producer to a consumer
+#define ITEM_COUNT 1000000
+
+MIDI_ring_buffer * ring;
+// Amount of items removed by a discarding producer
+unsigned long discarded = 0;
+
+void * producer(void * ptr) {
+    for (unsigned long i = 0; i < ITEM_COUNT; i++) {
+        // Spin while the ring is full
+        while (!ring_buffer_push(ring, &i));
+    }
+    return NULL;
+}
+
+void * discarding_producer(void * ptr) {
+    unsigned long item;
+    for (unsigned long i = 0; i < ITEM_COUNT; i++) {
+        // Make room by removing the oldest item instead of waiting
+        if (ring_buffer_full(ring) && ring_buffer_discard_oldest(ring, &item, NULL)) discarded++;
+        while (!ring_buffer_push(ring, &i));
+    }
+    return NULL;
+}
+
+int main() {
+    pthread_t producer_thread;
+    unsigned long item;
+    unsigned long expected = 0;
+    bool ordered = true;
+
+    // A capacity is rounded up to a power of two
+    init_ring_buffer(&ring, 100, sizeof(unsigned long));
+    printf("Capacity: %zu\n", ring->capacity);
+
+    // A capacity without a power of two in size_t is rejected
+    MIDI_ring_buffer * huge;
+    bool rejected = init_ring_buffer(&huge, (size_t) -1, 1) != 0 && huge == NULL;
+    printf("Huge capacity rejected: %d\n", rejected);
+    if (!rejected) ordered = false;
+
+    // An empty ring can't be popped
+    printf("Empty pop: %d\n", ring_buffer_pop(ring, &item));
+
+    pthread_create(&producer_thread, NULL, producer, NULL);
+    while (expected < ITEM_COUNT) {
+        if (!ring_buffer_pop(ring, &item)) continue;
+        if (item != expected) ordered = false;
+        expected++;
+    }
+    pthread_join(producer_thread, NULL);
+
+    printf("Items received: %lu\n", expected);
+    printf("Order kept: %d\n", ordered);
+    printf("Items left: %zu\n", ring_buffer_count(ring));
+
+    // Batch reads wrap around the end of slot storage
+    unsigned long batch[128];
+    size_t batch_count;
+    for (unsigned long i = 0; i < 100; i++) ring_buffer_push(ring, &i);
+    batch_count = ring_buffer_pop_batch(ring, batch, 128);
+    for (size_t i = 0; i < batch_count; i++) {
+        if (batch[i] != i) ordered = false;
+    }
+    printf("Batch items received: %zu\n", batch_count);
+    printf("Batch order kept: %d\n", ordered && batch_count == 100);
+    if (batch_count != 100) ordered = false;
+
+    free_ring_buffer(ring);
+
+    // A producer discarding the oldest items never blocks,
+    // a consumer sees the rest in order and without duplicates
+    init_ring_buffer(&ring, 64, sizeof(unsigned long));
+    if (ring_buffer_enable_discard(ring) != 0) return 1;
+    pthread_create(&producer_thread, NULL, discarding_producer, NULL);
+    unsigned long received = 0;
+    bool increasing = true;
+    long last = -1;
+    while (1) {
+        batch_count = ring_buffer_pop_batch(ring, batch, 16);
+        for (size_t i = 0; i < batch_count; i++) {
+            if ((long) batch[i] <= last) increasing = false;
+            last = batch[i];
+        }
+        received += batch_count;
+        if (last == ITEM_COUNT - 1) break;
+    }
+    pthread_join(producer_thread, NULL);
+    printf("Discard order kept: %d\n", increasing);
+    printf("Nothing lost: %d\n", received + discarded == ITEM_COUNT);
+    if (!increasing || received + discarded != ITEM_COUNT) ordered = false;
+    free_ring_buffer(ring);
+
+    // Exit with an error if items were lost or reordered
+    return ordered ? 0 : 1;
+}